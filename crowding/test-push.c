@@ -0,0 +1,130 @@
+/* Author: Yuriy Sverchkov
+   Filename: test-push.c
+   Purpose: Checks the disassembly push chains (ring_head, push_down and
+   push_up in ../ift/exclusion.c) against a brute-force reference on random
+   configurations, and that can_disassemble (../ift/ift.c) refuses the
+   disassemblies after which the IFTs would not fit.  Prints the number of
+   failures and exits with 1 if there are any.
+*/
+
+#include "ift.c"
+
+#define N_CONFIGS 100000
+#define MAX_LENGTH 40
+
+int brute_force( int count[], const int length )
+/* Reference: count[length+1+i] is the number of IFTs at position i for
+   -(length+1) <= i <= length+1.  Moves the IFTs off the disassembled
+   positions, then settles every position holding more than one IFT by
+   moving the extra IFTs on, one position at a time. */
+{
+   int i, moved = 0;
+   int * c = count + length + 1;
+
+   if( c[length+1] > 0 ){
+      --c[length+1]; ++c[length];
+      for( i = length; i > -length-1; i-- )
+         while( c[i] > 1 ){ --c[i]; ++c[i-1]; ++moved; }
+   }
+
+   if( c[-length-1] > 0 ){
+      --c[-length-1]; ++c[-length];
+      for( i = -length; i < length+1; i++ )
+         while( c[i] > 1 ){ --c[i]; ++c[i+1]; ++moved; }
+   }
+
+   return moved;
+}
+
+int main( int argc, char* argv[] ){
+
+   int x[2*MAX_LENGTH+3], count[2*MAX_LENGTH+3], check[2*MAX_LENGTH+3];
+   int lattice[2*MAX_LENGTH+3];
+   unsigned config, failures = 0, n, i, k, rotation, head, block;
+   int length, pos;
+   Rng * rng = rng_create();
+
+   rng_init( rng, 4357 );
+
+   for( config = 0; config < N_CONFIGS; config++ ){
+
+      /* Length after the disassembly, and a number of IFTs on the old
+         lattice, which may not fit the new one */
+      length = rng_uint32( rng ) % MAX_LENGTH;
+      n = 1 + rng_uint32( rng ) % ( 2*length + 3 );
+
+      /* Only a number that fits can disassemble */
+      if( !can_disassemble( n, length + 1 ) != ( n > 2*(unsigned) length + 1 ) ){
+         printf( "Config %u: length %d, %u IFTs, disassembly %s\n", config,
+            length + 1, n, n > 2*(unsigned) length + 1 ? "allowed" : "refused" );
+         ++failures;
+         continue;
+      }
+      if( n > 2*(unsigned) length + 1 ) continue;
+
+      /* Distinct positions on the old lattice -(length+1)..length+1, often
+         with a contiguous block at one or both ends. */
+      for( i = 0; i < 2*length+3; i++ ) lattice[i] = 0;
+      k = 0;
+      block = rng_uint32( rng ) % 4;
+      if( block & 1 )
+         for( pos = length+1; pos > -length-1 && k < n/2; pos-- ){
+            lattice[length+1+pos] = 1; ++k;
+            if( rng_uint32( rng ) % 4 == 0 ) break;
+         }
+      if( block & 2 )
+         for( pos = -length-1; pos < length+1 && k < n; pos++ ){
+            if( lattice[length+1+pos] ) break;
+            lattice[length+1+pos] = 1; ++k;
+            if( rng_uint32( rng ) % 4 == 0 ) break;
+         }
+      while( k < n ){
+         pos = rng_uint32( rng ) % ( 2*length + 3 );
+         if( !lattice[pos] ){ lattice[pos] = 1; ++k; }
+      }
+
+      /* Lay them out around the ring starting at a random index */
+      rotation = rng_uint32( rng ) % n;
+      k = 0;
+      for( i = 0; i < 2*length+3; i++ )
+         if( lattice[i] ) x[ (rotation + k++) % n ] = i - length - 1;
+
+      /* Code under test */
+      head = ring_head( x, n );
+      if( head != rotation ){
+         printf( "Config %u: ring_head returned %u instead of %u\n",
+            config, head, rotation );
+         ++failures;
+         continue;
+      }
+      k = push_down( x, n, length, (head+n-1) % n );
+      k += push_up( x, n, length, head );
+
+      /* Reference */
+      for( i = 0; i < 2*length+3; i++ ) count[i] = lattice[i];
+      brute_force( count, length );
+
+      /* Compare the occupancies, and check the order around the ring and
+         the positions are kept, and that nothing is left off the lattice */
+      for( i = 0; i < 2*length+3; i++ ) check[i] = 0;
+      for( i = 0; i < n; i++ ) ++check[ x[i] + length + 1 ];
+      for( i = 0; i < 2*length+3; i++ )
+         if( check[i] != count[i] ) break;
+      if( i < 2*length+3 || check[0] != 0 || check[2*length+2] != 0 ){
+         printf( "Config %u: length %d, %u IFTs, occupancy differs at %d\n",
+            config, length, n, (int) i - length - 1 );
+         ++failures;
+         continue;
+      }
+      for( i = 1; i < n; i++ )
+         if( x[ (head+i) % n ] <= x[ (head+i-1) % n ] ) break;
+      if( i < n ){
+         printf( "Config %u: ring out of order\n", config );
+         ++failures;
+      }
+   }
+
+   rng_destroy( rng );
+   printf( "%u configurations, %u failures\n", N_CONFIGS, failures );
+   return failures > 0;
+}
@@ -1,13 +1,19 @@
-function [ ] = write_IFT_init( filename, L, x0 )
-%function [ ] = write_IFT_init( filename, L, x0 )
+function [ ] = write_IFT_init( filename, L, x0, speed )
+%function [ ] = write_IFT_init( filename, L, x0, speed )
 % Writes an Initial Conditions (binary) file for the IFT C
 % simulation (L is the 
 %
+% speed (optional) gives each IFT a speed relative to the rates in the
+% parameters file, and must have as many elements as x0.
+%
 
 file = fopen( filename, 'w' );
 
 fwrite( file, L, 'int32' );
 fwrite( file, length(x0), 'int32' );
 fwrite( file, x0, 'int32' );
+if nargin > 3
+  fwrite( file, speed, 'double' );
+end
 
-fclose( file );
\ No newline at end of file
+fclose( file );
@@ -0,0 +1,99 @@
+/* Author: Yuriy Sverchkov
+   Filename: bench-interleave.c
+   Purpose: Times ensembles stepped K runs at a time (see interleave.c) for
+   K = 1 to MAX_K and prints the events per second of each engine, on
+   N_IFTS IFTs in a flagellum of length LENGTH0.  Every K runs the same
+   seeded streams, so the runs must end the same as with K = 1: exits with
+   1 if any does not.
+*/
+
+#include "ift.c"
+
+#define N_RUNS 256
+#define N_IFTS 10
+#define LENGTH0 20
+#define TIME_LIMIT 200.0
+#define MAX_K 16
+
+typedef struct{
+	unsigned next;
+	int * length;
+	int64_t events;
+} Bench;
+
+int bench_take( void * context, unsigned * run ){
+
+	Bench * b = context;
+
+	if( b->next >= N_RUNS ) return 0;
+	*run = b->next++;
+	return 1;
+}
+
+void bench_put( void * context, const unsigned run,
+	const RunRecord * record )
+{
+	Bench * b = context;
+
+	b->length[run] = record->length;
+	b->events += record->events;
+}
+
+int main( int argc, char* argv[] ){
+
+	const char * names[] = { "grouped", "direct", NULL };
+	const Parameters p = { 1.0, 1.0, 2.0 };
+	const Seeding seeding = { 1, 2012, 0, RNG_DEFAULT, NULL };
+	int x0[N_IFTS], first[N_RUNS], length[N_RUNS];
+	InitialConditions ic;
+	const Engine * engine;
+	Interleave * il;
+	Bench b;
+	unsigned i, k, e;
+	int failures = 0;
+	clock_t start;
+	double seconds;
+
+	ift_dispatch();
+
+	for( i = 0; i < N_IFTS; i++ )
+		x0[i] = 2 * (int) i - LENGTH0 + 1;
+	ic.time_limit = TIME_LIMIT;
+	ic.length0 = LENGTH0;
+	ic.n_ifts = N_IFTS;
+	ic.x0 = x0;
+	ic.speed = NULL;
+
+	for( e = 0; names[e] != NULL; e++ ){
+
+		engine = find_engine( names[e] );
+		printf( "%s:\n", engine->name );
+
+		for( k = 1; k <= MAX_K; k *= 2 ){
+
+			b.next = 0;
+			b.length = k == 1 ? first : length;
+			b.events = 0;
+
+			il = interleave_create( engine, &ic, k );
+			interleave_seed( il, &seeding, 0 );
+			start = clock();
+			interleave_runs( il, engine, &p, &ic, &seeding, bench_take, bench_put,
+				&b );
+			seconds = (double) ( clock() - start ) / CLOCKS_PER_SEC;
+			interleave_destroy( il, engine );
+
+			printf( "  K = %2u: %.3g events/s", k,
+				seconds > 0 ? b.events / seconds : 0 );
+
+			if( k > 1 && memcmp( first, length, sizeof(first) ) != 0 ){
+				printf( " (runs differ from K = 1)" );
+				++failures;
+			}
+			printf( "\n" );
+		}
+	}
+
+	printf( "Failures: %d\n", failures );
+	return failures > 0;
+}
@@ -0,0 +1,106 @@
+/* Author: Yuriy Sverchkov
+   File: dsfmt.c
+   Description: Double precision SIMD-oriented Fast Mersenne Twister
+   (dSFMT 2, by Mutsuo Saito and Makoto Matsumoto), period 2^19937-1.
+   Its output is IEEE doubles on [1,2) straight from the recursion: the 52
+   random bits are the mantissa and the exponent is fixed, so no integer is
+   converted.  Works on the RngBlock array of an Rng context.
+   Included by rng.c.
+*/
+
+#ifndef DSFMT_C_INCLUDED
+#define DSFMT_C_INCLUDED
+
+#define DSFMT_MEXP 19937
+#define DSFMT_N ( ( DSFMT_MEXP - 128 ) / 104 + 1 )
+#define DSFMT_POS1 117
+#define DSFMT_SL1 19
+#define DSFMT_SR 12
+#define DSFMT_MSK1 0x000ffafffffffb3fULL
+#define DSFMT_MSK2 0x000ffdfffc90fffdULL
+#define DSFMT_FIX1 0x90014964b32f4329ULL
+#define DSFMT_FIX2 0x3b8d12ac548a7c7aULL
+#define DSFMT_PCV1 0x3d84e1ac0dc82880ULL
+#define DSFMT_PCV2 0x0000000000000001ULL
+#define DSFMT_LOW_MASK 0x000fffffffffffffULL
+#define DSFMT_HIGH_CONST 0x3ff0000000000000ULL
+
+/* The state is DSFMT_N blocks of output followed by the "lung" block. */
+
+#if defined(HAVE_SSE2)
+
+void dsfmt_regenerate( RngBlock * w )
+/* Replaces blocks 0 to DSFMT_N-1 with the next DSFMT_N blocks of output. */
+{
+	int i;
+	__m128i x, z, lung = w[DSFMT_N].si;
+	const __m128i mask = _mm_set_epi32( (int)( DSFMT_MSK2 >> 32 ),
+		(int)( DSFMT_MSK2 & 0xffffffffUL ), (int)( DSFMT_MSK1 >> 32 ),
+		(int)( DSFMT_MSK1 & 0xffffffffUL ) );
+
+	for( i = 0; i < DSFMT_N; i++ ){
+		x = w[i].si;
+		z = _mm_xor_si128( _mm_slli_epi64( x, DSFMT_SL1 ),
+			w[ i < DSFMT_N - DSFMT_POS1 ? i + DSFMT_POS1 : i + DSFMT_POS1 - DSFMT_N ].si );
+		/* Swaps the 32-bit halves of each word of the lung, and the words */
+		lung = _mm_xor_si128( _mm_shuffle_epi32( lung, 0x1b ), z );
+		w[i].si = _mm_xor_si128( _mm_xor_si128( _mm_srli_epi64( lung, DSFMT_SR ),
+			_mm_and_si128( lung, mask ) ), x );
+	}
+
+	w[DSFMT_N].si = lung;
+}
+
+#else
+
+void dsfmt_regenerate( RngBlock * w )
+/* Replaces blocks 0 to DSFMT_N-1 with the next DSFMT_N blocks of output. */
+{
+	int i, k;
+	uint64_t t0, t1, l0, l1;
+	RngBlock * b;
+
+	l0 = w[DSFMT_N].u64[0];
+	l1 = w[DSFMT_N].u64[1];
+
+	for( i = 0; i < DSFMT_N; i++ ){
+		k = i < DSFMT_N - DSFMT_POS1 ? i + DSFMT_POS1 : i + DSFMT_POS1 - DSFMT_N;
+		b = &( w[k] );
+		t0 = w[i].u64[0];
+		t1 = w[i].u64[1];
+		t0 = ( t0 << DSFMT_SL1 ) ^ ( l1 >> 32 ) ^ ( l1 << 32 ) ^ b->u64[0];
+		t1 = ( t1 << DSFMT_SL1 ) ^ ( l0 >> 32 ) ^ ( l0 << 32 ) ^ b->u64[1];
+		l0 = t0;
+		l1 = t1;
+		w[i].u64[0] ^= ( l0 >> DSFMT_SR ) ^ ( l0 & DSFMT_MSK1 );
+		w[i].u64[1] ^= ( l1 >> DSFMT_SR ) ^ ( l1 & DSFMT_MSK2 );
+	}
+
+	w[DSFMT_N].u64[0] = l0;
+	w[DSFMT_N].u64[1] = l1;
+}
+
+#endif
+
+void dsfmt_prepare( RngBlock * w )
+/* Turns DSFMT_N+1 blocks of seeded words into a valid state: makes the
+   output words doubles on [1,2), and makes sure the period is 2^19937-1 by
+   fixing one bit of the lung if necessary. */
+{
+	int i;
+	uint64_t inner;
+
+	for( i = 0; i < DSFMT_N; i++ ){
+		w[i].u64[0] = ( w[i].u64[0] & DSFMT_LOW_MASK ) | DSFMT_HIGH_CONST;
+		w[i].u64[1] = ( w[i].u64[1] & DSFMT_LOW_MASK ) | DSFMT_HIGH_CONST;
+	}
+
+	inner = ( ( w[DSFMT_N].u64[0] ^ DSFMT_FIX1 ) & DSFMT_PCV1 )
+		^ ( ( w[DSFMT_N].u64[1] ^ DSFMT_FIX2 ) & DSFMT_PCV2 );
+	for( i = 32; i > 0; i >>= 1 )
+		inner ^= inner >> i;
+	if( !( inner & 1 ) )
+		w[DSFMT_N].u64[1] ^= 1; /* The lowest bit set in DSFMT_PCV2 */
+}
+
+#endif
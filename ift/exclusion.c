@@ -0,0 +1,73 @@
+/* Author: Yuriy Sverchkov
+   File: exclusion.c
+   Description: Pushing IFTs out of the way of a disassembly under the
+   exclusion movement rule, where no two IFTs share a position.  The
+   positions are kept in increasing order around the ring of positions
+   -length to +length (see InitialConditions in ift.c).  The new ring must
+   hold every IFT, which engines see to by not disassembling otherwise (see
+   can_disassemble in ift.c).
+   Included by ift.c.
+*/
+
+#ifndef EXCLUSION_C_INCLUDED
+#define EXCLUSION_C_INCLUDED
+
+unsigned ring_head( const int x[], const unsigned n_ifts )
+/* Returns the index of the IFT closest to the retrograde end, for positions
+   that increase around the ring x[0..n_ifts-1] (see InitialConditions).
+   Binary search for the point where the ring wraps, n_ifts must be > 0. */
+{
+	unsigned lo = 0, hi = n_ifts - 1, mid;
+
+	while( lo < hi ){
+		mid = lo + ( hi - lo ) / 2;
+		if( x[mid] > x[hi] ) lo = mid + 1;
+		else hi = mid;
+	}
+
+	return lo;
+}
+
+unsigned push_down( int x[], const unsigned n_ifts, const int length,
+	unsigned tail )
+/* Resolves the anterograde end of a disassembly to the given length.
+   If IFT tail (the one closest to the tip) is at length+1, it moves to
+   length, and every IFT right behind it moves back one position as well.
+   Returns the number of IFTs moved: tail and the ones before it around the
+   ring. */
+{
+	unsigned moved = 0;
+
+	if( x[tail] != length + 1 ) return 0;
+
+	/* Walk back over the contiguous block ending at the old tip */
+	do{
+		--x[tail];
+		tail = ( tail + n_ifts - 1 ) % n_ifts;
+	}while( ++moved < n_ifts && x[tail] == x[(tail+1) % n_ifts] );
+
+	return moved;
+}
+
+unsigned push_up( int x[], const unsigned n_ifts, const int length,
+	unsigned head )
+/* Resolves the retrograde end of a disassembly to the given length.
+   If IFT head (the one closest to the retrograde end) is at -(length+1), it
+   moves to -length, and every IFT right ahead of it moves forward one
+   position as well.  Returns the number of IFTs moved: head and the ones
+   after it around the ring. */
+{
+	unsigned moved = 0;
+
+	if( x[head] != -length - 1 ) return 0;
+
+	/* Walk forward over the contiguous block starting at the old end */
+	do{
+		++x[head];
+		head = ( head + 1 ) % n_ifts;
+	}while( ++moved < n_ifts && x[head] == x[(head+n_ifts-1) % n_ifts] );
+
+	return moved;
+}
+
+#endif
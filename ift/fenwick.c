@@ -0,0 +1,75 @@
+/* Author: Yuriy Sverchkov
+   File: fenwick.c
+   Description: Implements Fenwick (binary indexed) trees of counts, which
+   support updating a count and finding the cell holding the k-th unit of the
+   total in logarithmic time.
+*/
+
+#ifndef FENWICK_C_INCLUDED
+#define FENWICK_C_INCLUDED
+
+#include <stdlib.h>
+
+typedef struct {
+	unsigned int size;/*Number of cells*/
+	unsigned int top;/*Largest power of two not above size*/
+	long * tree;/*tree[i] holds the sum of cells i-(i&-i) to i-1 (1-based)*/
+} Fenwick;
+
+Fenwick fwCreate( const unsigned int size )
+/* Creates a Fenwick tree of the specified size with all counts zero. */
+{
+	unsigned int i;
+	Fenwick result;
+
+	result.tree = (long *) malloc( ( size + 1 ) * sizeof(long) );
+	result.size = size;
+	for( result.top = 1; result.top * 2 <= size; result.top *= 2 );
+
+	for( i = 0; i <= size; i++ )
+		result.tree[i] = 0;
+
+	return result;
+}
+
+void fwDestroy( Fenwick f )
+/* Deallocates a Fenwick tree's dynamic contents. */
+{
+	free(f.tree);
+	return;
+}
+
+void fwAdd( Fenwick * f, unsigned int index, const long delta )
+/* Adds delta to the count in cell index. */
+{
+	for( ++index; index <= f->size; index += index & -index )
+		f->tree[index] += delta;
+	return;
+}
+
+long fwPrefix( const Fenwick * f, unsigned int index )
+/* Returns the sum of the counts in cells 0 to index-1. */
+{
+	long sum = 0;
+
+	for( ; index > 0; index -= index & -index )
+		sum += f->tree[index];
+	return sum;
+}
+
+unsigned int fwFind( const Fenwick * f, long k )
+/* Returns the first cell i such that the counts in cells 0 to i sum to more
+   than k, for 0 <= k < total.  Counts must be nonnegative. */
+{
+	unsigned int step, index = 0;
+
+	for( step = f->top; step > 0; step /= 2 )
+		if( index + step <= f->size && f->tree[index + step] <= k ){
+			index += step;
+			k -= f->tree[index];
+		}
+
+	return index;
+}
+
+#endif
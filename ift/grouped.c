@@ -0,0 +1,149 @@
+/* Author: Yuriy Sverchkov
+   Filename: grouped.c
+   Purpose: Grouped-propensity engine for the IFT simulation.
+   Every anterograde IFT moves at lambda_p and every retrograde IFT at
+   lambda_m, so instead of building a vector of n_ifts+1 rates each step we
+   keep the set of IFTs in each direction, pick the kind of event from the
+   three class totals and then pick a member of the class uniformly.
+   Included by ift.c.
+*/
+
+#ifndef GROUPED_C_INCLUDED
+#define GROUPED_C_INCLUDED
+
+#include "idset.c"
+
+typedef struct{
+	unsigned n_ifts;
+	int * x;
+	IdSet ante;
+	IdSet retro;
+} GroupedState;
+/*GroupedState: State of the grouped-propensity engine
+
+n_ifts - Number of IFT's.
+x - IFT positions (same notation as x0 in the InitialConditions struct).
+ante - IFTs moving anterograde (x >= 0).
+retro - IFTs moving retrograde (x < 0).
+*/
+
+
+void * grouped_create( const InitialConditions * const ic ){
+
+	GroupedState * s = (GroupedState *) malloc( sizeof(GroupedState) );
+
+	s->n_ifts = ic->n_ifts;
+	s->x = (int *) malloc( ( ic->n_ifts + (ic->n_ifts == 0) ) * sizeof(int) );
+	s->ante = idsCreate( ic->n_ifts );
+	s->retro = idsCreate( ic->n_ifts );
+
+	return s;
+}
+
+void grouped_reset( void * state, const InitialConditions * const ic ){
+
+	GroupedState * s = state;
+	unsigned i;
+
+	idsClear( &(s->ante) );
+	idsClear( &(s->retro) );
+
+	for( i = 0; i < s->n_ifts; i++ ){
+		s->x[i] = ic->x0[i];
+		idsInsert( s->x[i] >= 0 ? &(s->ante) : &(s->retro), i );
+	}
+}
+
+void grouped_destroy( void * state ){
+
+	GroupedState * s = state;
+
+	idsDestroy( s->ante );
+	idsDestroy( s->retro );
+	free( s->x );
+	free( s );
+}
+
+int grouped_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+/*int grouped_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+Represents a single step of the simulation, with the same dynamics as
+ift_step but O(1) event selection.
+
+Return value:
+The change in length (+1, 0, or -1)
+*/
+{
+	GroupedState * s = state;
+	unsigned i, j;
+	double temp;
+	double tau = 0;
+	double ante_rate = p->lambda_p * s->ante.size;
+	double retro_rate = p->lambda_m * s->retro.size;
+	double rate_sum = ante_rate + retro_rate + p->mu * ( *length > 0 );
+	short length_change = 0;
+
+	if( rate_sum <= 0 ){ /* Impossible */
+		tau = time_limit - *t;
+		printf( "The sum of rates was nonpositive (%g).", rate_sum );
+	}else{
+		/* Get time until next event */
+		tau = ift_wait( rng ) / rate_sum;
+
+		/* Check if next event is within the time limit */
+		if( tau + *t > time_limit )
+			tau = time_limit - *t;
+		else{
+			/* Pick the event class, then an IFT within the class */
+
+			temp = rate_sum * rng_uniform( rng );
+
+			if( temp < ante_rate ){ /* Anterograde move */
+
+				j = idsPick( &(s->ante), temp / ante_rate );
+
+				if( ++(s->x[j]) > *length ){ /* Then assembly occurs */
+
+					*length += ( length_change = +1 );
+					s->x[j] = -(*length);
+					idsRemove( &(s->ante), j );
+					idsInsert( &(s->retro), j );
+				}
+
+			}else if( ( temp -= ante_rate ) < retro_rate ){ /* Retrograde move */
+
+				j = idsPick( &(s->retro), temp / retro_rate );
+
+				if( ++(s->x[j]) == 0 ){ /* Reached the base */
+					idsRemove( &(s->retro), j );
+					idsInsert( &(s->ante), j );
+				}
+
+			}else{ /* Disassembly */
+
+				*length += ( length_change = -1 );
+
+				/* Move IFTs on Disassembled segment down. */
+				for( i = 0; i < s->n_ifts; i++ )
+					if( s->x[i] == (*length)+1 )
+						--(s->x[i]);
+					else if( s->x[i] == -(*length)-1 && ++(s->x[i]) == 0 ){
+						/* Pushed onto the base */
+						idsRemove( &(s->retro), i );
+						idsInsert( &(s->ante), i );
+					}
+			}
+		}
+	}
+
+	/* Update time */
+	*t += tau;
+
+	return length_change;
+}
+
+const Engine grouped_engine = { "grouped",
+	grouped_create, grouped_reset, grouped_step, grouped_destroy, 0 };
+
+#endif
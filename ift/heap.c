@@ -0,0 +1,103 @@
+/* Author: Yuriy Sverchkov
+   File: heap.c
+   Description: Implements indexed binary min-heaps of times: every id from
+   0 to size-1 is always in the heap, with a key that can be changed in
+   logarithmic time, and the id with the smallest key is at the top.
+*/
+
+#ifndef HEAP_C_INCLUDED
+#define HEAP_C_INCLUDED
+
+#include <stdlib.h>
+#include <math.h>
+
+typedef struct {
+	unsigned int size;/*Number of ids*/
+	unsigned int * ids;/*The heap: the key of ids[i] is at most those of ids[2i+1] and ids[2i+2]*/
+	unsigned int * slot;/*slot[id] is the position of id in ids*/
+	double * key;/*key[id] is the key of id*/
+} IndexHeap;
+
+IndexHeap ihCreate( const unsigned int size )
+/* Creates a heap of ids 0 to size-1, all with key HUGE_VAL. */
+{
+	unsigned int i, real_size = size + (size == 0);
+	IndexHeap result;
+
+	result.ids = (unsigned int *) malloc( real_size * sizeof(unsigned int) );
+	result.slot = (unsigned int *) malloc( real_size * sizeof(unsigned int) );
+	result.key = (double *) malloc( real_size * sizeof(double) );
+	result.size = size;
+
+	for( i = 0; i < size; i++ ){
+		result.ids[i] = result.slot[i] = i;
+		result.key[i] = HUGE_VAL;
+	}
+
+	return result;
+}
+
+void ihDestroy( IndexHeap h )
+/* Deallocates an IndexHeap's dynamic contents. */
+{
+	free(h.ids);
+	free(h.slot);
+	free(h.key);
+	return;
+}
+
+static void ihPlace( IndexHeap * h, const unsigned int k, const unsigned int id ){
+	h->ids[k] = id;
+	h->slot[id] = k;
+}
+
+static void ihDown( IndexHeap * h, unsigned int k, const unsigned int id )
+/* Puts id in slot k or below it, moving up the children with smaller keys. */
+{
+	unsigned int c;
+
+	while( ( c = 2*k + 1 ) < h->size ){
+		if( c + 1 < h->size && h->key[ h->ids[c+1] ] < h->key[ h->ids[c] ] ) ++c;
+		if( h->key[ h->ids[c] ] >= h->key[id] ) break;
+		ihPlace( h, k, h->ids[c] );
+		k = c;
+	}
+
+	ihPlace( h, k, id );
+}
+
+void ihSet( IndexHeap * h, const unsigned int id, const double key )
+/* Changes the key of id, moving it up or down the heap. */
+{
+	unsigned int k = h->slot[id];
+
+	h->key[id] = key;
+
+	/* Up, while the parent has a larger key */
+	while( k > 0 && h->key[ h->ids[ (k-1)/2 ] ] > key ){
+		ihPlace( h, k, h->ids[ (k-1)/2 ] );
+		k = (k-1)/2;
+	}
+
+	ihDown( h, k, id );
+	return;
+}
+
+void ihBuild( IndexHeap * h )
+/* Restores the heap order after the keys were written directly into key[]
+   (in linear time). */
+{
+	unsigned int k;
+
+	for( k = h->size / 2; k > 0; k-- )
+		ihDown( h, k-1, h->ids[k-1] );
+	return;
+}
+
+unsigned int ihTop( const IndexHeap * h )
+/* Returns the id with the smallest key.  The heap must not be empty. */
+{
+	return h->ids[0];
+}
+
+#endif
@@ -0,0 +1,246 @@
+/* Author: Yuriy Sverchkov
+   Filename: hybrid.c
+   Purpose: Hybrid engine for the IFT simulation, leaping the hops and firing
+   the critical events exactly (after Cao, Gillespie and Petzold, 2005).
+   Leaping (see tauleap.c) holds the length fixed over a leap and applies
+   its assemblies and disassemblies together at the end, which is harmless
+   in bulk transport but not when a few of them change the length a lot
+   relative to itself.  Before each leap the engine looks at what it would
+   hold.  Assemblies and disassemblies are critical if
+   - the length is below HYBRID_LENGTH, where a few disassemblies take the
+     length to 0, and a leap would drop some;
+   - the leap may change the length by 1 at most (see tauleap_bound), so
+     that it would hold about one assembly or disassembly anyway, and an
+     exact one costs no more; held fixed over many such leaps, the length
+     drifts a little;
+   - more IFTs are expected to reach the tip in the leap than the length is
+     allowed to change by, as when they are clustered there.
+   A critical leap ends at the first assembly or disassembly (or at
+   time_limit): each IFT's next arrival at the tip is an Erlang number of
+   hops away (through the base for a retrograde IFT), and the next
+   disassembly an exponential time.  That event takes place exactly, and the
+   other IFTs stop where a binomial split of their hops puts them, as in the
+   round-trip engine (see roundtrip.c).  Nothing is held fixed over such a
+   leap, so it is exact.  The hops are leaped either way, and the length
+   changes one event at a time where it is critical.  The choice is made
+   anew at every leap.
+   Each state counts its critical leaps over its runs, and the engine
+   reports them with the other leaps.  Like tauleap.c it gives ensembles
+   the assemblies and disassemblies of its last leap (see Engine).
+   Included by ift.c for the free movement rule (IFT_MOVE).
+*/
+
+#ifndef HYBRID_C_INCLUDED
+#define HYBRID_C_INCLUDED
+
+#include "tauleap.c"
+
+/* Lengths below which assemblies and disassemblies are critical */
+#ifndef HYBRID_LENGTH
+#define HYBRID_LENGTH 10
+#endif
+
+typedef struct{
+	TauLeapState * leap;
+	double * base;
+	double * tip;
+	int64_t critical;
+	double critical_time;
+} HybridState;
+/*HybridState: State of the hybrid engine
+
+leap - the leaping engine's state, which holds the IFT positions for both
+	kinds of leaps and counts the others.
+base, tip - workspace: when each IFT reaches the base and the tip in a
+	critical leap.
+critical, critical_time - the number of critical leaps and the time they
+	covered, over every run of the state.
+*/
+
+
+void * hybrid_create( const InitialConditions * const ic ){
+
+	HybridState * s = (HybridState *) malloc( sizeof(HybridState) );
+
+	s->leap = (TauLeapState *) tauleap_create( ic );
+	s->base = (double *) malloc( ( ic->n_ifts + 1 ) * sizeof(double) );
+	s->tip = (double *) malloc( ( ic->n_ifts + 1 ) * sizeof(double) );
+	s->critical = 0;
+	s->critical_time = 0;
+
+	return s;
+}
+
+void hybrid_reset( void * state, const InitialConditions * const ic ){
+	tauleap_reset( ( (HybridState *) state )->leap, ic );
+}
+
+void hybrid_destroy( void * state ){
+
+	HybridState * s = state;
+
+	tauleap_destroy( s->leap );
+	free( s->base );
+	free( s->tip );
+	free( s );
+}
+
+void hybrid_report( void * const states[], const unsigned n ){
+
+	const HybridState * s;
+	void ** leaps = (void **) malloc( ( n + 1 ) * sizeof(void *) );
+	int64_t critical = 0;
+	double critical_time = 0, leap_time = 0;
+	unsigned i;
+
+	for( i = 0; i < n; i++ ){
+		s = states[i];
+		leaps[i] = s->leap;
+		critical += s->critical;
+		critical_time += s->critical_time;
+		leap_time += s->leap->leap_time;
+	}
+
+	printf( "Critical leaps: %lld, covering %.3g%% of the time.\n",
+		(long long) critical, critical_time + leap_time > 0 ?
+		100 * critical_time / ( critical_time + leap_time ) : 0 );
+	tauleap_report( leaps, n );
+	free( leaps );
+}
+
+short hybrid_critical( const HybridState * s, const Parameters * const p,
+	const double tau, const int length )
+/* Returns nonzero if the assemblies and disassemblies in a leap of tau from
+   the given length are critical. */
+{
+	const TauLeapState * l = s->leap;
+	const double bound = tauleap_bound( length );
+	double speed;
+	unsigned i, near = 0;
+
+	if( length < HYBRID_LENGTH || bound <= 1 ) return 1;
+
+	/* IFTs expected to reach the tip within the leap */
+	for( i = 0; i < l->n_ifts; i++ ){
+		speed = l->speed ? l->speed[i] : 1;
+		if( l->x[i] >= 0 )
+			near += length - l->x[i] + 1 <= speed * p->lambda_p * tau;
+	}
+
+	return near > bound;
+}
+
+int hybrid_leap( HybridState * s, const Parameters * const p, Rng * rng,
+	const double tau, double * t, int * length )
+/* Leaps up to the first assembly or disassembly, which then takes place, or
+   over tau if none comes sooner.  Returns the change in length. */
+{
+	TauLeapState * l = s->leap;
+	const unsigned n = l->n_ifts;
+	double speed, wait, end = tau;
+	unsigned i, hops, first = n + 1; /* n stands for a disassembly, n + 1 for none */
+	int change = 0;
+
+	/* When each IFT next reaches the tip, and which event comes first */
+	for( i = 0; i < n; i++ ){
+		speed = l->speed ? l->speed[i] : 1;
+		s->base[i] = s->tip[i] = HUGE_VAL;
+		if( l->x[i] >= 0 ){
+			if( speed * p->lambda_p > 0 )
+				s->tip[i] = rand_erlang( rng, *length - l->x[i] + 1,
+					speed * p->lambda_p );
+		}else if( speed * p->lambda_m > 0 ){
+			s->base[i] = rand_erlang( rng, -(l->x[i]), speed * p->lambda_m );
+			/* The way on is only needed if the base comes soon enough */
+			if( s->base[i] < end && speed * p->lambda_p > 0 )
+				s->tip[i] = s->base[i] + rand_erlang( rng, *length + 1,
+					speed * p->lambda_p );
+		}
+		if( s->tip[i] < end ){
+			end = s->tip[i];
+			first = i;
+		}
+	}
+	if( *length > 0 && p->mu > 0 && ( wait = rand_exp( rng ) / p->mu ) < end ){
+		end = wait;
+		first = n;
+	}
+
+	/* Where the other IFTs are at the end */
+	for( i = 0; i < n; i++ ){
+		if( i == first ) continue;
+		if( l->x[i] >= 0 ){
+			hops = *length - l->x[i] + 1;
+			if( s->tip[i] < HUGE_VAL && hops > 1 )
+				l->x[i] += rand_binomial( rng, hops - 1, end / s->tip[i] );
+		}else if( s->base[i] > end ){
+			hops = -(l->x[i]);
+			if( s->base[i] < HUGE_VAL && hops > 1 )
+				l->x[i] += rand_binomial( rng, hops - 1, end / s->base[i] );
+		}else{ /* Turned at the base */
+			l->x[i] = 0;
+			if( s->tip[i] < HUGE_VAL && *length > 0 )
+				l->x[i] = rand_binomial( rng, *length,
+					( end - s->base[i] ) / ( s->tip[i] - s->base[i] ) );
+		}
+	}
+
+	if( first < n ){ /* Then assembly occurs */
+		l->x[first] = -(*length)-1;
+		++(*length);
+		change = 1;
+	}else if( first == n ){ /* Disassembly */
+		--(*length);
+		change = -1;
+
+		/* Move IFTs on Disassembled segment down. */
+		for( i = 0; i < n; i++ )
+			if( l->x[i] > *length ) l->x[i] = *length;
+			else if( l->x[i] < -(*length) ) l->x[i] = -(*length);
+	}
+
+	l->last_assemblies = change > 0;
+	l->last_disassemblies = change < 0;
+	++(s->critical);
+	s->critical_time += end;
+	*t += end;
+
+	return change;
+}
+
+void hybrid_counts( const void * state, int64_t * assemblies,
+	int64_t * disassemblies )
+/* Gives the assemblies and disassemblies of the last leap of either kind. */
+{
+	tauleap_counts( ( (const HybridState *) state )->leap, assemblies,
+		disassemblies );
+}
+
+int hybrid_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+/*int hybrid_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+Represents a single step of the simulation: a leap (as tauleap_step), which
+ends at the first assembly or disassembly if they are critical.
+
+Return value:
+The change in length (the net change over a leap; +1, 0, or -1 for a
+critical one)
+*/
+{
+	HybridState * s = state;
+	TauLeapState * l = s->leap;
+	const double tau = tauleap_size( l, p, time_limit - *t, *length );
+
+	/* A critical leap is exact, so it need not stop short of time_limit */
+	if( hybrid_critical( s, p, tau, *length ) )
+		return hybrid_leap( s, p, rng, time_limit - *t, t, length );
+
+	return tauleap_leap( l, p, rng, tau, t, length );
+}
+
+const Engine hybrid_engine = { "hybrid",
+	hybrid_create, hybrid_reset, hybrid_step, hybrid_destroy, 1,
+	hybrid_report, hybrid_counts };
+
+#endif
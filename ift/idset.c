@@ -0,0 +1,89 @@
+/* Author: Yuriy Sverchkov
+   File: idset.c
+   Description: Implements sets of IFT indices with constant time insertion,
+   removal and uniform selection of a member.
+*/
+
+#ifndef IDSET_C_INCLUDED
+#define IDSET_C_INCLUDED
+
+#include <stdlib.h>
+
+typedef struct {
+	unsigned int size;/*Number of members*/
+	unsigned int * ids;/*Members, in no particular order*/
+	unsigned int * slot;/*slot[id] is the position of id in ids, or capacity if absent*/
+	unsigned int capacity;/*Ids range from 0 to capacity-1*/
+} IdSet;
+
+IdSet idsCreate( const unsigned int capacity )
+/* Creates an empty IdSet that can hold ids 0 to capacity-1. */
+{
+	unsigned int i, real_capacity = capacity + (capacity == 0);
+	IdSet result;
+
+	result.ids = (unsigned int *) malloc( real_capacity * sizeof(unsigned int) );
+	result.slot = (unsigned int *) malloc( real_capacity * sizeof(unsigned int) );
+	result.capacity = capacity;
+	result.size = 0;
+
+	for( i = 0; i < capacity; i++ )
+		result.slot[i] = capacity;
+
+	return result;
+}
+
+void idsDestroy( IdSet s )
+/* Deallocates an IdSet's dynamic contents. */
+{
+	free(s.ids);
+	free(s.slot);
+	return;
+}
+
+void idsClear( IdSet * s )
+/* Removes all members. */
+{
+	while( s->size > 0 )
+		s->slot[ s->ids[ --(s->size) ] ] = s->capacity;
+	return;
+}
+
+int idsHas( const IdSet * s, const unsigned int id ){
+	return s->slot[id] < s->capacity;
+}
+
+void idsInsert( IdSet * s, const unsigned int id )
+/* Adds id to the set (does nothing if it is already a member). */
+{
+	if( s->slot[id] < s->capacity ) return;
+
+	s->slot[id] = s->size;
+	s->ids[ s->size++ ] = id;
+	return;
+}
+
+void idsRemove( IdSet * s, const unsigned int id )
+/* Removes id from the set by moving the last member into its slot (does
+   nothing if id is not a member). */
+{
+	unsigned int last, k = s->slot[id];
+
+	if( k >= s->capacity ) return;
+
+	last = s->ids[ --(s->size) ];
+	s->ids[k] = last;
+	s->slot[last] = k;
+	s->slot[id] = s->capacity;
+	return;
+}
+
+unsigned int idsPick( const IdSet * s, const double u )
+/* Returns the member in slot floor(u*size), for u in [0,1).
+   The set must not be empty. */
+{
+	unsigned int k = (unsigned int)( u * s->size );
+	return s->ids[ k < s->size ? k : s->size - 1 ];
+}
+
+#endif
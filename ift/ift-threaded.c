@@ -1,328 +1,405 @@
 /* Author: Yuriy Sverchkov
-   Filename: ift_threaded.c
+   Filename: ift-threaded.c
    Purpose: Simulate the growth of a flagellum as a stochastic process.
-   This version uses pthread to run faster.
+   This version uses pthread to run ensembles faster: a pool of worker
+   threads, each with its own engine state and random number generator,
+   shares out the runs.  Each worker starts with an equal slice of the runs
+   and, when it is done with its own, steals half of what is left of another
+   worker's slice, so one slow run never holds up the other workers.
+   A run is simulated in the worker's own variables; only its results are
+   published, into a slot on a cache line of its own.  Workers and slots are
+   cache-line aligned so that threads never write to a line another thread
+   is using.
    Original simulation algorithm (written in MATLAB) by Dr. Muruhan Rathinam
 */
 
-#ifndef IFT_C_INCLUDED
-#define IFT_C_INCLUDED
+#ifndef IFT_THREADED_C_INCLUDED
+#define IFT_THREADED_C_INCLUDED
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
-#include <math.h>
-#include <unistd.h>
 #include <pthread.h>
-#include "SFMT-src-1.3/SFMT.h"
-#include "ydarrays.c"
+#include "ift.c"
+
+typedef union{
+	struct{
+		int length;
+		int64_t events;
+		int64_t assemblies;
+		int64_t disassemblies;
+	} r;
+	char pad[CACHE_LINE];
+} RunSlot;
+/*RunSlot: Results of one run, alone on its cache line
+
+length - the length at time_limit.
+events, assemblies, disassemblies - the number of events, assemblies and
+	disassemblies during the run.
+*/
 
-/* For how many threads? */
-#define N_THREADS 8
 
 typedef struct{
-	double lambda_p;
-	double lambda_m;
-	double mu;
-} Parameters;
-/*Parameters: Stores simulation parameters
-
-lambda_p - the rate and IFT of moving anterograde (towards tip).
-lambda_m - the rate of an IFT moving retrograde.
-mu - the rate of dissassembly.
+	pthread_mutex_t lock;
+	unsigned next;
+	unsigned end;
+} RunQueue;
+/*RunQueue: Runs waiting for a worker
+
+next - the next run the owner takes.
+end - one past the last run in the queue; thieves take runs from this end.
 */
 
+struct WorkerPool;
+
 typedef struct{
-	double time_limit;
-	int length0;
-	unsigned n_ifts;
-	int * x0;
-} InitialConditions;
-/*InitialConditions: Stores the initial conditions for the simulation
-
-n_ifts - Number of IFT's.
-x0 - Array of IFT positions, where positions are numbered -length to +length, with positive positions
-	representing anterograde (towards tip) transport, and negative positions represent retrograde
-	transport with the base of the flagellum at 0 and the tip at +/-length.
-length0 - initial length of flagellum.
-time_limit - the time limit for the simulation.
+	struct WorkerPool * pool;
+	pthread_t thread;
+	unsigned id;
+	unsigned generation;
+	RunQueue queue;
+	Interleave * runs;
+} Worker;
+/*Worker: A thread of a WorkerPool
+
+pool - the pool the worker belongs to.
+id - the index of the worker in the pool.
+generation - the last job the worker has started on.
+queue - the runs assigned to the worker.
+runs - the worker's runs, stepped in turn (see interleave.c), with engine
+	states reused from run to run and generators seeded with the worker's
+	own streams (or with each run's stream for fixed seeding).
 */
 
-
-void seed()
-/* Seeds the random number generator */
-{
-/*	unsigned int r[2];
-	r[0] = time(NULL);
-	r[1] = getpid();
-	init_by_array( r, 2 );*/
-	init_gen_rand( time(NULL) );
-}
-
-
-int ift_step( const Parameters * const p,
-	const double time_limit, double * t, int * length,
-	int x[], const unsigned n_ifts )
-/*int ift_step( const Parameters * const p,
-	const double time_limit, double * t, int * length,
-	int x[], const unsigned n_ifts )
-Represents a single step of the simulation.
-
-Inputs:
-p - (see comment on the Parameters struct)
-time_limit - the time limit for the simulation.
-n_ifts - the number of IFT's.
-
-Changing (input and output) variables:
-t - the current time.
-length - the current flagellum length.
-x - array of IFT (directed) positions (same notation as x0 in the InitialConditions struct).
-
-Return value:
-The change in length (+1, 0, or -1)
+typedef struct WorkerPool{
+	unsigned n_workers;
+	Worker ** workers;
+	const Engine * engine;
+	const InitialConditions * ic;
+
+	const Parameters * p;
+	const Seeding * seeding;
+	RunSlot * slots;
+	char * done;
+	unsigned n_runs;
+	unsigned n_done;
+
+	unsigned generation;
+	unsigned n_idle;
+	short quit;
+	pthread_mutex_t lock;
+	pthread_cond_t job_ready;
+	pthread_cond_t run_done;
+} WorkerPool;
+/*WorkerPool: Threads that stay alive between ensembles
+
+n_workers, workers - the worker threads (each on its own cache lines).
+engine, ic - the simulation algorithm and the initial conditions for every run.
+p, seeding, slots, n_runs - the current job: parameters, how to seed the
+	runs, where to put the results, and how many runs.
+done, n_done - which runs and how many of them are complete.
+generation - incremented when a new job is posted.
+n_idle - the number of workers done with the current job (or waiting for
+	the first one); a job is only posted when every worker is idle.
+quit - set to make the workers exit.
+lock - protects the fields above (except the queues, which have their own).
+job_ready - signalled when a job is posted or the pool is shutting down.
+run_done - signalled when a run completes or a worker goes idle.
 */
-{
 
-	int i, j; double temp, temp2;
-	double tau = 0;
-	double rate_sum = 0;
-	double rates[n_ifts];
-	short length_change = 0;
 
+int pool_take_run( Worker * w, unsigned * run )
+/* Takes the next run from the worker's own queue, or steals the back half
+   of another worker's queue.  Returns 0 if no runs are left anywhere. */
+{
+	WorkerPool * pool = w->pool;
+	Worker * victim;
+	unsigned k, mid, end;
+
+	pthread_mutex_lock( &(w->queue.lock) );
+	if( w->queue.next < w->queue.end ){
+		*run = w->queue.next++;
+		pthread_mutex_unlock( &(w->queue.lock) );
+		return 1;
+	}
+	pthread_mutex_unlock( &(w->queue.lock) );
 
-	/* Rate Calculations */
-
-	for( i = 0; i < n_ifts; i++ )
-		/* Get x[i]'s rate */
-		rate_sum += ( rates[i] =
-			p->lambda_p * ( x[i] >= 0 ) + p->lambda_m * ( x[i] < 0 ) );
+	for( k = 1; k < pool->n_workers; k++ ){
 
-	/* Add disassembly rate */
-	rate_sum += ( rates[n_ifts] = p->mu * ( *length > 0 ) );
+		victim = pool->workers[ (w->id + k) % pool->n_workers ];
 
-	if( rate_sum <= 0 ){ /* Impossible */
-		tau = time_limit - *t;
-		printf( "The sum of rates was nonpositive (%g).", rate_sum );
-	}else{
-		/* Get time until next event */
-/*		tau = ( 1 / rate_sum ) * log( ((double)RAND_MAX + 1.0) / (double)rand() );
-*/		tau = ( 1 / rate_sum ) * log( 1.0 / genrand_real2() );
+		pthread_mutex_lock( &(victim->queue.lock) );
+		if( victim->queue.next < victim->queue.end ){
+			end = victim->queue.end;
+			mid = end - ( end - victim->queue.next + 1 ) / 2;
+			victim->queue.end = mid;
+			pthread_mutex_unlock( &(victim->queue.lock) );
 
-		/* Check if next event is within the time limit */
-		if( tau + *t > time_limit )
-			tau = time_limit - *t;
-		else{
-			/* Pick next event */
+			pthread_mutex_lock( &(w->queue.lock) );
+			w->queue.next = mid + 1;
+			w->queue.end = end;
+			pthread_mutex_unlock( &(w->queue.lock) );
 
-			temp = rate_sum * genrand_real2();
+			*run = mid;
+			return 1;
+		}
+		pthread_mutex_unlock( &(victim->queue.lock) );
+	}
 
-			temp2 = 0;
-			j = 0;
-			while( ( ( temp2 += rates[j] ) <= temp ) && ( j++ < n_ifts ) );
-			/* j is now the event number */
+	return 0;
+}
 
-			if( j == n_ifts ){ /* Disassembly */
+int worker_take( void * context, unsigned * run ){
+	return pool_take_run( (Worker *) context, run );
+}
 
-				/* Decrease Length. */
-				*length += ( length_change = -1 );
+void worker_put( void * context, const unsigned run,
+	const RunRecord * record )
+/* Publishes the results of a run. */
+{
+	WorkerPool * pool = ((Worker *) context)->pool;
+	RunSlot * slot = &( pool->slots[run] );
+
+	slot->r.length = record->length;
+	slot->r.events = record->events;
+	slot->r.assemblies = record->assemblies;
+	slot->r.disassemblies = record->disassemblies;
+
+	pthread_mutex_lock( &(pool->lock) );
+	pool->done[run] = 1;
+	++(pool->n_done);
+	pthread_cond_signal( &(pool->run_done) );
+	pthread_mutex_unlock( &(pool->lock) );
+}
 
-				/* Move IFTs on Disassembled segment down. */
-				for( i = 0; i < n_ifts; i++ )
-					x[i] += -(x[i] == (*length)+1) + (x[i] == -(*length)-1);
+void * pool_worker( void * argptr ){
 
-			}else /* Move IFT */
+	Worker * w = argptr;
+	WorkerPool * pool = w->pool;
 
-				if( ++x[j] > *length ){ /* Then assembly occurs */
+	for( ;; ){
 
-					/* Increase length. */
-					*length += ( length_change = +1 );
-					/* Change direction on IFT */
-					x[j] = -(*length);
-				}
+		/* Wait for a job */
+		pthread_mutex_lock( &(pool->lock) );
+		while( pool->generation == w->generation && !pool->quit )
+			pthread_cond_wait( &(pool->job_ready), &(pool->lock) );
+		if( pool->quit ){
+			pthread_mutex_unlock( &(pool->lock) );
+			return NULL;
 		}
-	}
+		w->generation = pool->generation;
+		pthread_mutex_unlock( &(pool->lock) );
 
-	/* Update time */
-	*t += tau;
+		interleave_runs( w->runs, pool->engine, pool->p, pool->ic,
+			pool->seeding, worker_take, worker_put, w );
 
-	return length_change;
+		pthread_mutex_lock( &(pool->lock) );
+		++(pool->n_idle);
+		pthread_cond_signal( &(pool->run_done) );
+		pthread_mutex_unlock( &(pool->lock) );
+	}
 }
 
-void ift_trajectory( const Parameters * const p, const InitialConditions * const ic,
-	DoubleArray * t_array, IntArray * l_array)
-/*void ift_trajectory( const Parameters * const p, const InitialConditions * const ic,
-	DoubleArray * t_array, IntArray * l_array)
-
-Runs the IFT simulation once, recording the length and time at every length change.
- 
-Input:
-p - The transport and disassembly rates (see comment on Parameters struct)
-ic - Simulation initial conditions (see comment on InitialConditions struct)
-
-Output parameters:
-t_array - Array of times at which the length changes.
-l_array - Array of lengths corresponding to the times in t_array.
-
-*/
+static void pool_wait_idle( WorkerPool * pool )
+/* Waits, with pool->lock held, until every worker is done with the last
+   job: none is still taking runs or stepping its states. */
 {
-	/*Generic counter*/
-	unsigned int i;
+	while( pool->n_idle < pool->n_workers )
+		pthread_cond_wait( &(pool->run_done), &(pool->lock) );
+}
 
-	unsigned int n_l_changes = 0; /*Length change counter*/
-	int length = ic->length0; /*Current flagellum length*/
-	int x[ic->n_ifts]; /*IFT positions*/
-	double t = 0; /*Current time*/
-	DoubleArray times; /*Records length change times*/
-	IntArray lengths; /*Records lengths*/
+WorkerPool * pool_create( const unsigned n_workers,
+	const Engine * const engine, const InitialConditions * const ic,
+	const unsigned interleave )
+/* Starts n_workers threads (at least one), each stepping interleave runs in
+   turn, with engine states for the given initial conditions. */
+{
+	WorkerPool * pool = (WorkerPool *) cache_alloc( sizeof(WorkerPool) );
+	Worker * w;
+	unsigned i;
+
+	/* Decided once, before the workers make any numbers */
+	ift_dispatch();
+
+	pool->n_workers = n_workers > 0 ? n_workers : 1;
+	pool->workers = (Worker **) malloc( pool->n_workers * sizeof(Worker *) );
+	pool->engine = engine;
+	pool->ic = ic;
+	pool->generation = 0;
+	pool->n_idle = pool->n_workers;
+	pool->quit = 0;
+	pthread_mutex_init( &(pool->lock), NULL );
+	pthread_cond_init( &(pool->job_ready), NULL );
+	pthread_cond_init( &(pool->run_done), NULL );
+
+	for( i = 0; i < pool->n_workers; i++ ){
+		pool->workers[i] = w = (Worker *) cache_alloc( sizeof(Worker) );
+		w->pool = pool;
+		w->id = i;
+		w->generation = 0;
+		w->queue.next = w->queue.end = 0;
+		pthread_mutex_init( &(w->queue.lock), NULL );
+		w->runs = interleave_create( engine, ic, interleave );
+	}
 
-	/*** Initialization ***/
+	for( i = 0; i < pool->n_workers; i++ )
+		pthread_create( &(pool->workers[i]->thread), NULL, pool_worker,
+			pool->workers[i] );
 
-	/* Random number generator seed */
-/*	srand( time( NULL ) );
-*/	seed();
-
-	/* Sets Initial positions of IFT's. */
-	for( i = 0; i < ic->n_ifts ; i++ ) x[i] = ic->x0[i];
-
-	/* Sets "Step 0" times and lengths */
-	times = daCreate( NULL, 0 );
-	lengths = iaCreate( NULL, 0 );
-	daSet( &times, 0, 0 );
-	iaSet( &lengths, 0, ic->length0 );
-
-	/*** Main Loop ***/
-	while( t < ic->time_limit )
-		if(
-			ift_step( p, ic->time_limit, &t, &length, x, ic->n_ifts ) != 0
-			|| t == ic->time_limit )
-		{
-			++n_l_changes;
-			daSet( &times, n_l_changes, t );
-			iaSet( &lengths, n_l_changes, length );
-		}
+	return pool;
+}
 
-	*t_array = times;
-	*l_array = lengths;
+void pool_destroy( WorkerPool * pool )
+/* Stops the workers and deallocates the pool. */
+{
+	unsigned i;
+
+	pthread_mutex_lock( &(pool->lock) );
+	pool->quit = 1;
+	pthread_cond_broadcast( &(pool->job_ready) );
+	pthread_mutex_unlock( &(pool->lock) );
+
+	for( i = 0; i < pool->n_workers; i++ ){
+		pthread_join( pool->workers[i]->thread, NULL );
+		pthread_mutex_destroy( &(pool->workers[i]->queue.lock) );
+		interleave_destroy( pool->workers[i]->runs, pool->engine );
+		cache_free( pool->workers[i] );
+	}
 
-	printf("\nFinished.\n");
-	return;
+	pthread_mutex_destroy( &(pool->lock) );
+	pthread_cond_destroy( &(pool->job_ready) );
+	pthread_cond_destroy( &(pool->run_done) );
+	free( pool->workers );
+	cache_free( pool );
 }
 
 
+void pool_report( const WorkerPool * pool )
+/* Has the engine report on the runs of every worker (see Engine). */
+{
+	void ** states;
+	unsigned i, k = pool->workers[0]->runs->k;
 
-/* Thread-related:
- * RunArgs - struct that stores arguments passed to and from the thread
- * function.
- * one_run - function that makes one run (for the pthread).
- */
-typedef struct{
-	Parameters p;
-	InitialConditions ic;
-	int * result; /* The result goes here */
-}RunArgs;
-
-void * one_run( void * argptr ){
-
-	int j;
-	RunArgs * args = argptr;
-	/* Initial conditions */
-	double t = 0; /* time */
-	int x[args->ic.n_ifts]; /* IFT positions */
-
-	   /* Sets Initial positions of IFT's and lengths. */
-	   for( j = 0; j < args->ic.n_ifts; j++ )
-		   x[j] = args->ic.x0[j];
-	   *(args->result) = args->ic.length0;
-
-	   while( t < args->ic.time_limit )
-	      ift_step( &(args->p), args->ic.time_limit, &t, args->result, x,
-		args->ic.n_ifts );
-	   free( argptr );
-	return NULL;
+	if( pool->engine->report == NULL ) return;
+
+	states = (void **) malloc( pool->n_workers * k * sizeof(void *) );
+	for( i = 0; i < pool->n_workers * k; i++ )
+		states[i] = pool->workers[ i / k ]->runs->state[ i % k ];
+	pool->engine->report( states, pool->n_workers * k );
+	free( states );
 }
 
 
-void ift_ensemble(
+void ift_ensemble_threaded(
    const Parameters * const p,
-   const InitialConditions * const ic,
+   WorkerPool * pool,
+   const Seeding * const seeding,
    const unsigned int n_runs,
    int l_array[],
+   int64_t events_array[],
+   int64_t assemblies_array[],
+   int64_t disassemblies_array[],
    const char * backup)
-/*void ift_ensemble( const Parameters * const p, const InitialConditions * const ic,
-	const unsigned int n_runs, int l_array[])
+/*void ift_ensemble_threaded( const Parameters * const p, WorkerPool * pool,
+	const Seeding * const seeding, const unsigned int n_runs, int l_array[],
+	int64_t events_array[], int64_t assemblies_array[],
+	int64_t disassemblies_array[],
+	const char * backup)
+
+Runs the IFT simulation repeatedly on the pool's workers, recording the
+length at time_limit and the event counts of each run.
 
-Runs the IFT simulation repeatedly, recording only the lengths at time_limit for each run.
+backup - filename of backup file, rewritten with the completed runs at the
+	start of l_array every 10 runs.
 
-backud - filename of backup file.
- 
 Input:
 p - The transport and disassembly rates (see comment on Parameters struct)
-ic - Simulation initial conditions (see comment on InitialConditions struct)
+pool - Worker threads, set up with the engine and initial conditions.
+seeding - How to seed the random number generators (see comment on Seeding
+	struct).  With fixed seeding the lengths do not depend on the number of
+	workers.
 n_runs - the number of times to run the simulation.
 
 Output:
 l_array - Array of lengths corresponding to the different runs.
+events_array - Array of event counts per run.
+assemblies_array - Array of assembly events per run.
+disassemblies_array - Array of disassembly events per run.
 
 */
 {
 	FILE * out;
-	unsigned int i,j;
-
-	/*int length; **Current flagellum length**
-	double t; **Current time*/
-
-	RunArgs thread_args, *argsptr;
-	pthread_t threads[N_THREADS];
+	Worker * w;
+	RunSlot * slot;
+	unsigned int i, first, prefix = 0, backed_up = 0;
 
 	/*** Initialization ***/
 
-	/* Random number generator seed */
-	seed();
-
-	/* Initial conditions for all threads */
-	thread_args.p = *p; thread_args.ic = *ic; thread_args.result=NULL;
-
-	/*** Main Loop ***/
-	for( i = 0; i < n_runs; i += N_THREADS ){
-
-	   /* Sets Initial positions of IFT's and lengths. **
-	   for( j = 0; j < ic->n_ifts; j++ ) x[j] = ic->x0[j];
-	   length = ic->length0;
-
-	   t = 0;
-	   while( t < ic->time_limit )
-	      ift_step( p, ic->time_limit, &t, &length, x, ic->n_ifts );
-
-	   l_array[i] = length;
-	   */
-
-	   for( j=0; j<N_THREADS && i+j < n_runs; j++ ){
-
-		argsptr = malloc( sizeof( RunArgs ) );
-		/*Need to remember to deallocate inside thread*/
-		*argsptr = thread_args;
-		argsptr->result = &( l_array[i+j] );
-		pthread_create(
-			&( threads[j] ), NULL, one_run, argsptr );
+	/*** Post the job: an equal slice of the runs for each worker ***/
+	pthread_mutex_lock( &(pool->lock) );
+	pool_wait_idle( pool );
+	pool->p = p;
+	pool->seeding = seeding;
+	pool->slots = (RunSlot *) cache_alloc( ( n_runs + 1 ) * sizeof(RunSlot) );
+	pool->n_runs = n_runs;
+	pool->n_done = 0;
+	pool->done = (char *) calloc( n_runs + 1, 1 );
+
+	for( i = 0; i < pool->n_workers; i++ ){
+		w = pool->workers[i];
+		first = (unsigned)( (double) n_runs * i / pool->n_workers );
+		pthread_mutex_lock( &(w->queue.lock) );
+		w->queue.next = first;
+		w->queue.end = (unsigned)( (double) n_runs * ( i + 1 ) / pool->n_workers );
+		pthread_mutex_unlock( &(w->queue.lock) );
+
+		/* Random number generator seeds: streams of their own per worker */
+		interleave_seed( w->runs, seeding, i * w->runs->k );
+	}
 
-	   }
+	pool->n_idle = 0;
+	++(pool->generation);
+	pthread_cond_broadcast( &(pool->job_ready) );
 
-	   /* Write backup */
-	   if( i>0 && i%10 == 0 && (out = fopen( backup, "w" )) != NULL ){
+	/*** Wait for the runs, writing backups as they come in ***/
+	while( prefix < n_runs ){
 
-		fwrite( &i, sizeof(unsigned int), 1, out);
-		fwrite( l_array, sizeof(int), i, out);
-		fclose( out );
-	   }
+		/* Woken up by a worker (the check also catches runs that completed
+		   while the backup was written) */
+		if( !pool->done[prefix] ){
+			pthread_cond_wait( &(pool->run_done), &(pool->lock) );
+			continue;
+		}
 
-	   /* Wait for threads */
-	   for( j=0; j<N_THREADS && i+j < n_runs; j++ ){
-	   	pthread_join( threads[j], NULL );
-	   }
+		/* Collect the runs complete before the first missing one */
+		while( prefix < n_runs && pool->done[prefix] ){
+			slot = &( pool->slots[prefix] );
+			l_array[prefix] = slot->r.length;
+			events_array[prefix] = slot->r.events;
+			assemblies_array[prefix] = slot->r.assemblies;
+			disassemblies_array[prefix] = slot->r.disassemblies;
+			++prefix;
+		}
 
+		/* Write them without the lock, so that workers do not wait on the
+		   disk: only this thread writes l_array */
+		if( prefix >= backed_up + 10 ){
+			backed_up = prefix;
+			pthread_mutex_unlock( &(pool->lock) );
+			if( (out = fopen( backup, "w" )) != NULL ){
+				fwrite( &backed_up, sizeof(unsigned int), 1, out);
+				fwrite( l_array, sizeof(int), backed_up, out);
+				fclose( out );
+			}
+			pthread_mutex_lock( &(pool->lock) );
+		}
 	}
 
+	/* The states are read by the report, and the pool reused */
+	pool_wait_idle( pool );
+	free( pool->done );
+	cache_free( pool->slots );
+	pthread_mutex_unlock( &(pool->lock) );
+
 	printf("\nFinished.\n");
+	pool_report( pool );
 	return;
 }
 
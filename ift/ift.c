@@ -1,7 +1,10 @@
 /* Author: Yuriy Sverchkov
-   Filename: ift_threaded.c
+   Filename: ift.c
    Purpose: Simulate the growth of a flagellum as a stochastic process.
-   This version uses pthread to run faster.
+   This is the simulation core of every model.  The model is chosen at
+   compile time with three policies (see IFT_MOVE, IFT_RECORD and IFT_WAIT
+   below), which the front end defines before including this file: the
+   launchers here build the free model, ../crowding/ift.c the crowding one.
    Original simulation algorithm (written in MATLAB) by Dr. Muruhan Rathinam
 */
 
@@ -12,11 +15,39 @@
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include <string.h>
 #include <unistd.h>
-#include "../SFMT-src-1.3/SFMT.h"
+#include "rng.c"
+#include "randist.c"
 #include "ydarrays.c"
 
 
+/* Movement rules: IFTs pass through each other, or one waits while the
+   position ahead of it is taken. */
+#define MOVE_FREE 0
+#define MOVE_EXCLUSION 1
+
+/* What an ensemble records of each run: the final length, or that and the
+   event counts.  Trajectories always record every length change (see
+   run.c). */
+#define RECORD_FINAL 0
+#define RECORD_COUNTERS 1
+
+/* How waiting times are drawn: ziggurat (see randist.c) or inversion. */
+#define WAIT_ZIGGURAT 0
+#define WAIT_INVERSION 1
+
+#ifndef IFT_MOVE
+#define IFT_MOVE MOVE_FREE
+#endif
+#ifndef IFT_RECORD
+#define IFT_RECORD RECORD_COUNTERS
+#endif
+#ifndef IFT_WAIT
+#define IFT_WAIT WAIT_ZIGGURAT
+#endif
+
+
 typedef struct{
 	double lambda_p;
 	double lambda_m;
@@ -34,6 +65,7 @@ typedef struct{
 	int length0;
 	unsigned n_ifts;
 	int * x0;
+	double * speed;
 } InitialConditions;
 /*InitialConditions: Stores the initial conditions for the simulation
 
@@ -41,34 +73,178 @@ n_ifts - Number of IFT's.
 x0 - Array of IFT positions, where positions are numbered -length to +length, with positive positions
 	representing anterograde (towards tip) transport, and negative positions represent retrograde
 	transport with the base of the flagellum at 0 and the tip at +/-length.
+	With MOVE_EXCLUSION the array must be sorted in increasing order (the
+	launcher sorts it), and the order is then kept around the ring: the IFT
+	that reaches the tip becomes the one closest to -length.  The number of
+	IFTs should not exceed the 2*length+1 positions.
+speed - Array of the IFTs' speeds, relative to the rates in Parameters: IFT i
+	moves at speed[i]*lambda_p anterograde and speed[i]*lambda_m retrograde
+	(cargo-loaded trains and empty ones, for instance).  NULL if every IFT
+	moves at the rates in Parameters.  Only engines with speeds set (see
+	Engine) take it into account.
 length0 - initial length of flagellum.
 time_limit - the time limit for the simulation.
 */
 
+typedef struct{
+	const char * name;
+	void * (*create)( const InitialConditions * const ic );
+	void (*reset)( void * state, const InitialConditions * const ic );
+	int (*step)( void * state, const Parameters * const p, Rng * rng,
+		const double time_limit, double * t, int * length );
+	void (*destroy)( void * state );
+	short speeds;
+	void (*report)( void * const states[], const unsigned n );
+	void (*counts)( const void * state, int64_t * assemblies,
+		int64_t * disassemblies );
+} Engine;
+/*Engine: A simulation algorithm
+
+name - the name used to select the engine from the command line.
+create - allocates the engine's state for the given initial conditions.
+reset - sets the state to the initial IFT positions.
+step - advances the state by one event, drawing from rng (same contract as
+	ift_step), or by a leap of many (approximate engines), returning the
+	net change in length.
+destroy - deallocates the state.
+speeds - nonzero if the engine takes the IFTs' own speeds into account
+	(see InitialConditions).
+report - prints what the engine gathered over the runs of n of its states
+	(NULL, or left out, if the engine gathers nothing).
+counts - for engines whose step is a leap, gives the assemblies and
+	disassemblies of the last step (NULL, or left out, if a step is one
+	event and its change in length says which).
+*/
+
+
+#ifndef RNG_DEFAULT
+#define RNG_DEFAULT RNG_SFMT
+#endif
+
+typedef struct{
+	short fixed;
+	unsigned long seed;
+	unsigned long first_run;
+	short generator;
+	const RngPeriod * period;
+} Seeding;
+/*Seeding: How the runs get their random numbers
+
+fixed - zero to seed SFMT from the clock and the process id, nonzero to give
+	each run its own counter-based stream (see rng_init_counter), keyed by
+	seed and numbered by the run's index.  Run i then has the same
+	trajectory however the ensemble is split between threads or jobs.
+seed - the user seed (only if fixed).
+first_run - the index of the first run (only if fixed): a trajectory is run
+	first_run, an ensemble runs first_run to first_run+n_runs-1.
+generator - RNG_SFMT or RNG_DSFMT, the generator seeded from the clock (if
+	not fixed).  Defaults to RNG_DEFAULT, which can be set at build time.
+period - the period of SFMT (see rng_periods), or NULL for the default one
+	(set at build time with MEXP).
+*/
+
+
+void seed( Rng * rng, const Seeding * const seeding, const unsigned stream )
+/* Seeds a random number generator.  Generators seeded from the clock at the
+   same time with different stream numbers give unrelated sequences.  For
+   fixed seeding this does nothing: see seed_run. */
+{
+	uint32_t key[3];
+
+	if( seeding->fixed ) return;
+
+	key[0] = time(NULL);
+	key[1] = getpid();
+	key[2] = stream;
+	if( seeding->generator == RNG_DSFMT )
+		rng_init_double_by_array( rng, key, 3 );
+	else
+		rng_init_period_by_array( rng,
+			seeding->period ? seeding->period : RNG_DEFAULT_PERIOD, key, 3 );
+}
+
+void seed_run( Rng * rng, const Seeding * const seeding, const unsigned long run )
+/* Starts the stream of the given run (counted from first_run) if the
+   seeding is fixed. */
+{
+	uint32_t key[2], stream[2];
+	const unsigned long index = seeding->first_run + run;
+
+	if( !seeding->fixed ) return;
+
+	/* Shifts in two steps: unsigned long may be only 32 bits */
+	key[0] = (uint32_t) seeding->seed;
+	key[1] = (uint32_t)( ( seeding->seed >> 16 ) >> 16 );
+	stream[0] = (uint32_t) index;
+	stream[1] = (uint32_t)( ( index >> 16 ) >> 16 );
+	rng_init_counter( rng, key, stream );
+}
+
 
-void seed()
-/* Seeds the random number generator */
+double ift_wait( Rng * rng )
+/* Returns an exponential waiting time with rate 1, drawn as IFT_WAIT says. */
 {
-/*	unsigned int r[2];
-	r[0] = time(NULL);
-	r[1] = getpid();
-	init_by_array( r, 2 );*/
-	init_gen_rand( time(NULL) );
+#if IFT_WAIT == WAIT_INVERSION
+	return -log( rng_uniform_open( rng ) );
+#else
+	return rand_exp( rng );
+#endif
 }
 
+#define CACHE_LINE 64
 
-int ift_step( const Parameters * const p,
+void * cache_alloc( const size_t size )
+/* Allocates size bytes starting on a cache line, and padded to a whole
+   number of lines.  Free with cache_free.  Engines keep their per-IFT
+   arrays here: they are allocated once per state and reused by every
+   step, so the number of IFTs is only limited by the heap. */
+{
+	char * raw = (char *) malloc( size + 2 * CACHE_LINE );
+	char * p = raw + CACHE_LINE - ( (size_t) raw ) % CACHE_LINE;
+
+	if( p - raw < (long) sizeof(void *) ) p += CACHE_LINE;
+	((void **) p)[-1] = raw;
+	return p;
+}
+
+void cache_free( void * p ){
+	if( p != NULL ) free( ((void **) p)[-1] );
+}
+
+#if IFT_MOVE == MOVE_EXCLUSION
+#include "exclusion.c"
+#endif
+
+short can_disassemble( const unsigned n_ifts, const int length )
+/* Returns nonzero if the flagellum can disassemble from the given length.
+   With MOVE_EXCLUSION the shorter ring must still hold every IFT (at least
+   n_ifts positions from -(length-1) to length-1), or the pushed IFTs would
+   wrap around it; disassembly waits, at rate 0, until an assembly makes
+   room. */
+{
+#if IFT_MOVE == MOVE_EXCLUSION
+	return 2 * length > (int) n_ifts;
+#else
+	return length > 0;
+#endif
+}
+
+
+int ift_step( const Parameters * const p, Rng * rng,
 	const double time_limit, double * t, int * length,
-	int x[], const unsigned n_ifts )
-/*int ift_step( const Parameters * const p,
+	int x[], const unsigned n_ifts, const double speed[], double rates[] )
+/*int ift_step( const Parameters * const p, Rng * rng,
 	const double time_limit, double * t, int * length,
-	int x[], const unsigned n_ifts )
+	int x[], const unsigned n_ifts, const double speed[], double rates[] )
 Represents a single step of the simulation.
 
 Inputs:
 p - (see comment on the Parameters struct)
+rng - the random number generator.
 time_limit - the time limit for the simulation.
 n_ifts - the number of IFT's.
+speed - the speed of each IFT, or NULL (see InitialConditions).
+rates - workspace of n_ifts+1 doubles (its contents are overwritten).
 
 Changing (input and output) variables:
 t - the current time.
@@ -80,10 +256,12 @@ The change in length (+1, 0, or -1)
 */
 {
 
-	int i, j; double temp, temp2;
+	unsigned i, j; double temp, temp2;
+#if IFT_MOVE == MOVE_EXCLUSION
+	unsigned k;
+#endif
 	double tau = 0;
 	double rate_sum = 0;
-	double rates[n_ifts+1];
 	short length_change = 0;
 
 
@@ -91,11 +269,11 @@ The change in length (+1, 0, or -1)
 
 	for( i = 0; i < n_ifts; i++ )
 		/* Get x[i]'s rate */
-		rate_sum += ( rates[i] =
-			p->lambda_p * ( x[i] >= 0 ) + p->lambda_m * ( x[i] < 0 ) );
+		rate_sum += ( rates[i] = ( speed ? speed[i] : 1 ) *
+			( p->lambda_p * ( x[i] >= 0 ) + p->lambda_m * ( x[i] < 0 ) ) );
 
 	/* Add disassembly rate */
-	rate_sum += ( rates[n_ifts] = p->mu * ( *length > 0 ) );
+	rate_sum += ( rates[n_ifts] = p->mu * can_disassemble( n_ifts, *length ) );
 
 	if( rate_sum <= 0 ){ /* Impossible */
 		tau = time_limit - *t;
@@ -103,7 +281,7 @@ The change in length (+1, 0, or -1)
 	}else{
 		/* Get time until next event */
 /*		tau = ( 1 / rate_sum ) * log( ((double)RAND_MAX + 1.0) / (double)rand() );
-*/		tau = ( 1 / rate_sum ) * log( 1.0 / genrand_real2() );
+*/		tau = ift_wait( rng ) / rate_sum;
 
 		/* Check if next event is within the time limit */
 		if( tau + *t > time_limit )
@@ -111,7 +289,7 @@ The change in length (+1, 0, or -1)
 		else{
 			/* Pick next event */
 
-			temp = rate_sum * genrand_real2();
+			temp = rate_sum * rng_uniform( rng );
 
 			temp2 = 0;
 			j = 0;
@@ -123,6 +301,27 @@ The change in length (+1, 0, or -1)
 				/* Decrease Length. */
 				*length += ( length_change = -1 );
 
+#if IFT_MOVE == MOVE_EXCLUSION
+				/* Move IFTs on Disassembled segment down, possibly
+				   consequentially pushing adjacent IFTs as well. */
+				if( n_ifts > 0 ){
+					k = ring_head( x, n_ifts );
+					push_down( x, n_ifts, *length, (k+n_ifts-1) % n_ifts );
+					push_up( x, n_ifts, *length, k );
+				}
+
+			}else /* Move IFT */
+
+				if( x[j] > *length - 1 ){ /* Then assembly occurs */
+
+					/* Increase length. */
+					*length += ( length_change = +1 );
+					/* Change direction on IFT */
+					x[j] = -(*length);
+
+				}else /* Move IFT only if it isn't blocked */
+					if( x[(j+1)%n_ifts] != x[j] + 1 ) ++x[j];
+#else
 				/* Move IFTs on Disassembled segment down. */
 				for( i = 0; i < n_ifts; i++ )
 					x[i] += -(x[i] == (*length)+1) + (x[i] == -(*length)-1);
@@ -136,6 +335,7 @@ The change in length (+1, 0, or -1)
 					/* Change direction on IFT */
 					x[j] = -(*length);
 				}
+#endif
 		}
 	}
 
@@ -145,9 +345,299 @@ The change in length (+1, 0, or -1)
 	return length_change;
 }
 
+
+#if defined(RNG_DISPATCH) && IFT_MOVE == MOVE_FREE
+/* Fixed-capacity versions of ift_step for up to 64 IFTs (see small.c),
+   with SSE2 or AVX2, compiled whatever the target. */
+#define SMALL_STEPS
+
+#define SMALL_EMPTY ( -2147483647 - 1 )
+
+typedef int (*SmallStep)( int x[], const unsigned n_ifts,
+	const Parameters * const p, Rng * rng, const double time_limit,
+	double * t, int * length );
+
+static uint64_t small_sums( uint64_t mask )
+/* Returns the running bit counts of mask by byte: byte i of the result is
+   the number of bits set in bytes 0 to i of mask (so byte 7 is the total). */
+{
+	mask = mask - ( ( mask >> 1 ) & 0x5555555555555555ULL );
+	mask = ( mask & 0x3333333333333333ULL )
+		+ ( ( mask >> 2 ) & 0x3333333333333333ULL );
+	return ( ( mask + ( mask >> 4 ) ) & 0x0f0f0f0f0f0f0f0fULL )
+		* 0x0101010101010101ULL;
+}
+
+static unsigned small_select( const uint64_t mask, const double r )
+/* Returns the slot of set bit number r (rounded down, counting from the
+   lowest) of mask, or of its highest set bit if rounding put r past it.
+   Finds the byte from the running counts (Vigna, 2008), then halves the
+   byte down to the bit, all without branches. */
+{
+	const uint64_t sums = small_sums( mask );
+	const unsigned n = sums >> 56;
+	unsigned k = r < n ? (unsigned) r : n - 1, byte, bits, pairs, c, up, at;
+
+	/* Byte i has its high bit set if k is at least the count up to byte i */
+	byte = ( ( ( ( ( k * 0x0101010101010101ULL ) | 0x8080808080808080ULL )
+		- sums ) & 0x8080808080808080ULL ) >> 7 ) * 0x0101010101010101ULL >> 56;
+	k -= ( ( sums << 8 ) >> ( 8 * byte ) ) & 0xff;
+	bits = ( mask >> ( 8 * byte ) ) & 0xff;
+
+	/* Counts by pair of bits, then the low nibble */
+	pairs = bits - ( ( bits >> 1 ) & 0x55 );
+	c = ( pairs & 0x3 ) + ( ( pairs >> 2 ) & 0x3 );
+	up = -( k >= c );
+	at = 4 & up;
+	k -= c & up;
+	c = ( pairs >> at ) & 0x3;
+	up = -( k >= c );
+	at += 2 & up;
+	k -= c & up;
+	at += k >= ( ( bits >> at ) & 1 );
+
+	return 8 * byte + at;
+}
+
+#define SMALL_CAP 8
+#define SMALL_AVX2 0
+#include "small.c"
+#define SMALL_CAP 16
+#define SMALL_AVX2 0
+#include "small.c"
+#define SMALL_CAP 32
+#define SMALL_AVX2 0
+#include "small.c"
+#define SMALL_CAP 64
+#define SMALL_AVX2 0
+#include "small.c"
+#define SMALL_CAP 8
+#define SMALL_AVX2 1
+#include "small.c"
+#define SMALL_CAP 16
+#define SMALL_AVX2 1
+#include "small.c"
+#define SMALL_CAP 32
+#define SMALL_AVX2 1
+#include "small.c"
+#define SMALL_CAP 64
+#define SMALL_AVX2 1
+#include "small.c"
+
+int small_width = 0;
+/* IFTs per vector of the fixed-capacity steps: 4 (SSE2) or 8 (AVX2, with
+   BMI2 to pick the moving IFT), or 0 for SSE2 until small_dispatch is
+   called.  It can be set to 4 to force SSE2.  Both give the same numbers.
+   Engine states only read it. */
+
+void small_dispatch( void )
+/* Sets small_width, if not set yet, to the widest the processor supports. */
+{
+	if( small_width == 0 )
+		small_width = __builtin_cpu_supports( "avx2" )
+			&& __builtin_cpu_supports( "bmi2" ) ? 8 : 4;
+}
+
+SmallStep small_pick( const unsigned n_ifts, unsigned * capacity )
+/* Returns the fixed-capacity step for n_ifts IFTs and sets capacity to its
+   number of slots, or returns NULL if there are more than 64 IFTs. */
+{
+	static const SmallStep sse2[4] = { small_step_8_sse2, small_step_16_sse2,
+		small_step_32_sse2, small_step_64_sse2 };
+	static const SmallStep avx2[4] = { small_step_8_avx2, small_step_16_avx2,
+		small_step_32_avx2, small_step_64_avx2 };
+	int c;
+
+	for( c = 0; c < 4; c++ )
+		if( n_ifts <= 8u << c ){
+			*capacity = 8u << c;
+			return small_width == 8 ? avx2[c] : sse2[c];
+		}
+	return NULL;
+}
+
+#endif
+
+void ift_dispatch( void )
+/* Picks the vector instructions of the generators and of the
+   fixed-capacity steps, once, before any thread starts. */
+{
+	rng_dispatch();
+#if defined(SMALL_STEPS)
+	small_dispatch();
+#endif
+}
+
+
+/* Direct engine: ift_step on a plain array of positions.  The small engine
+   shares its state, and uses one of the fixed-capacity steps instead if
+   there are at most 64 IFTs. */
+
+typedef struct{
+	unsigned n_ifts;
+	int * x;
+	const double * speed;
+	double * rates;
+#if defined(SMALL_STEPS)
+	SmallStep small;
+#endif
+} DirectState;
+/*DirectState: State of the direct engine
+
+x - the IFT positions (padded with SMALL_EMPTY up to the capacity of the
+	fixed-capacity step, if there is one).
+speed - the IFTs' speeds, from the initial conditions.
+rates - workspace of ift_step, n_ifts+1 doubles.
+small - the fixed-capacity step (small engine), or NULL for ift_step.
+*/
+
+void * direct_create( const InitialConditions * const ic ){
+
+	DirectState * s = (DirectState *) malloc( sizeof(DirectState) );
+
+#if defined(SMALL_STEPS)
+	s->small = NULL;
+#endif
+	s->x = (int *) cache_alloc( (size_t) ic->n_ifts * sizeof(int) );
+	s->n_ifts = ic->n_ifts;
+	s->rates = (double *) cache_alloc( ( (size_t) ic->n_ifts + 1 ) * sizeof(double) );
+	return s;
+}
+
+#if defined(SMALL_STEPS)
+void * small_create( const InitialConditions * const ic ){
+
+	DirectState * s;
+	unsigned i, capacity;
+	SmallStep small = small_pick( ic->n_ifts, &capacity );
+
+	/* Over 64 IFTs the engine is the direct one */
+	if( small == NULL ) return direct_create( ic );
+
+	/* Cache lines are aligned enough for the vector loads */
+	s = (DirectState *) malloc( sizeof(DirectState) );
+	s->small = small;
+	s->x = (int *) cache_alloc( capacity * sizeof(int) );
+	for( i = 0; i < capacity; i++ ) s->x[i] = SMALL_EMPTY;
+	s->n_ifts = ic->n_ifts;
+	s->rates = NULL;
+	return s;
+}
+#endif
+
+void direct_reset( void * state, const InitialConditions * const ic ){
+
+	DirectState * s = state;
+	unsigned i;
+
+	for( i = 0; i < s->n_ifts; i++ ) s->x[i] = ic->x0[i];
+	s->speed = ic->speed;
+}
+
+int direct_step( void * state, const Parameters * const p, Rng * rng,
+	const double time_limit, double * t, int * length ){
+
+	DirectState * s = state;
+#if defined(SMALL_STEPS)
+	if( s->small )
+		return s->small( s->x, s->n_ifts, p, rng, time_limit, t, length );
+#endif
+	return ift_step( p, rng, time_limit, t, length, s->x, s->n_ifts, s->speed, s->rates );
+}
+
+void direct_destroy( void * state ){
+
+	DirectState * s = state;
+
+	cache_free( s->x );
+	cache_free( s->rates );
+	free( s );
+}
+
+const Engine direct_engine = { "direct",
+	direct_create, direct_reset, direct_step, direct_destroy, 1 };
+
+#if defined(SMALL_STEPS)
+/* The fixed-capacity steps all move at the rates in Parameters */
+const Engine small_engine = { "small",
+	small_create, direct_reset, direct_step, direct_destroy, 0 };
+#endif
+
+#if IFT_MOVE == MOVE_EXCLUSION
+
+#include "unblocked.c"
+#include "nextreaction.c"
+#include "rssa.c"
+#include "weighted.c"
+#include "uniformization.c"
+
+/* Available engines, the first one is the default. */
+const Engine * const engines[] = { &unblocked_engine, &rssa_engine,
+	&weighted_engine, &nextreaction_engine, &uniformization_engine,
+	&direct_engine, NULL };
+
+#else
+
+#include "grouped.c"
+#include "occupancy.c"
+#include "roundtrip.c"
+#include "nextreaction.c"
+#include "weighted.c"
+#include "uniformization.c"
+#include "tauleap.c"
+#include "hybrid.c"
+
+/* Available engines, the first one is the default. */
+const Engine * const engines[] = { &grouped_engine, &occupancy_engine,
+	&roundtrip_engine, &weighted_engine, &nextreaction_engine,
+	&uniformization_engine, &tauleap_engine, &hybrid_engine,
+#if defined(SMALL_STEPS)
+	&small_engine,
+#endif
+	&direct_engine, NULL };
+
+#endif
+
+const Engine * find_engine( const char * name )
+/* Returns the engine with the given name, or NULL if there is none. */
+{
+	unsigned i;
+
+	for( i = 0; engines[i] != NULL; i++ )
+		if( strcmp( engines[i]->name, name ) == 0 ) return engines[i];
+
+	return NULL;
+}
+
+
+typedef struct{
+	int length;
+	int64_t events;
+	int64_t assemblies;
+	int64_t disassemblies;
+	DoubleArray times;
+	IntArray lengths;
+} RunRecord;
+/*RunRecord: What a run records (which fields depends on the policy)
+
+length - the length at time_limit (every policy).
+events, assemblies, disassemblies - the number of events, assemblies and
+	disassemblies during the run (RECORD_COUNTERS).
+times, lengths - the times of the length changes and the lengths after
+	them, starting with time 0 (trajectories, see run.c).
+*/
+
+#include "run.c"
+
+/* Ensembles step their runs in turn, recording them as IFT_RECORD says */
+#include "interleave.c"
+
+
 void ift_trajectory( const Parameters * const p, const InitialConditions * const ic,
+	const Engine * const engine, const Seeding * const seeding,
 	DoubleArray * t_array, IntArray * l_array)
 /*void ift_trajectory( const Parameters * const p, const InitialConditions * const ic,
+	const Engine * const engine, const Seeding * const seeding,
 	DoubleArray * t_array, IntArray * l_array)
 
 Runs the IFT simulation once, recording the length and time at every length change.
@@ -155,6 +645,8 @@ Runs the IFT simulation once, recording the length and time at every length chan
 Input:
 p - The transport and disassembly rates (see comment on Parameters struct)
 ic - Simulation initial conditions (see comment on InitialConditions struct)
+engine - The simulation algorithm (see comment on Engine struct)
+seeding - How to seed the random number generator (see comment on Seeding struct)
 
 Output parameters:
 t_array - Array of times at which the length changes.
@@ -162,69 +654,137 @@ l_array - Array of lengths corresponding to the times in t_array.
 
 */
 {
-	/*Generic counter*/
-	unsigned int i;
-
-	unsigned int n_l_changes = 0; /*Length change counter*/
-	int length = ic->length0; /*Current flagellum length*/
-	int x[ic->n_ifts]; /*IFT positions*/
-	double t = 0; /*Current time*/
-	DoubleArray times; /*Records length change times*/
-	IntArray lengths; /*Records lengths*/
+	void * state = engine->create( ic ); /*IFT positions*/
+	Rng * rng = rng_create(); /*Random number generator*/
+	RunRecord record;
 
 	/*** Initialization ***/
 
 	/* Random number generator seed */
-/*	srand( time( NULL ) );
-*/	seed();
+	seed( rng, seeding, 0 );
+	seed_run( rng, seeding, 0 );
 
-	/* Sets Initial positions of IFT's. */
-	for( i = 0; i < ic->n_ifts ; i++ ) x[i] = ic->x0[i];
+	record.times = daCreate( NULL, 0 );
+	record.lengths = iaCreate( NULL, 0 );
 
-	/* Sets "Step 0" times and lengths */
-	times = daCreate( NULL, 0 );
-	lengths = iaCreate( NULL, 0 );
-	daSet( &times, 0, 0 );
-	iaSet( &lengths, 0, ic->length0 );
+	ift_run_trajectory( engine, state, p, rng, ic, &record );
 
-	/*** Main Loop ***/
-	while( t < ic->time_limit )
-		if(
-			ift_step( p, ic->time_limit, &t, &length, x, ic->n_ifts ) != 0
-			|| t == ic->time_limit )
-		{
-			++n_l_changes;
-			daSet( &times, n_l_changes, t );
-			iaSet( &lengths, n_l_changes, length );
-		}
+	printf("\nFinished.\n");
+	if( engine->report != NULL ) engine->report( &state, 1 );
 
-	*t_array = times;
-	*l_array = lengths;
+	engine->destroy( state );
+	rng_destroy( rng );
+
+	*t_array = record.times;
+	*l_array = record.lengths;
 
-	printf("\nFinished.\n");
 	return;
 }
 
 
+typedef struct{
+	unsigned next;
+	unsigned n_runs;
+	unsigned n_done;
+	unsigned prefix;
+	char * done;
+	int * l_array;
+	int64_t * events_array;
+	int64_t * assemblies_array;
+	int64_t * disassemblies_array;
+	const char * backup;
+} EnsembleJob;
+/*EnsembleJob: The runs of ift_ensemble
+
+next - the next run to give out.
+n_done, done - how many and which runs are complete.
+prefix - the number of runs complete before the first missing one.
+The other fields are ift_ensemble's arguments.
+*/
+
+void ensemble_job( EnsembleJob * job, const unsigned int n_runs,
+	int l_array[], int64_t events_array[], int64_t assemblies_array[],
+	int64_t disassemblies_array[], const char * backup )
+/* Sets up the job of an ensemble of n_runs runs, none done yet.  Free
+   job->done when it is over. */
+{
+	job->next = job->n_done = job->prefix = 0;
+	job->n_runs = n_runs;
+	job->done = (char *) calloc( n_runs + 1, 1 );
+	job->l_array = l_array;
+	job->events_array = events_array;
+	job->assemblies_array = assemblies_array;
+	job->disassemblies_array = disassemblies_array;
+	job->backup = backup;
+}
+
+int ensemble_take( void * context, unsigned * run ){
+
+	EnsembleJob * job = context;
+
+	if( job->next >= job->n_runs ) return 0;
+	*run = job->next++;
+	return 1;
+}
+
+void ensemble_put( void * context, const unsigned run,
+	const RunRecord * record )
+/* Stores a run's results, and writes the backup every 10 runs. */
+{
+	EnsembleJob * job = context;
+	FILE * out;
+	const unsigned before = job->prefix / 10;
+
+#if IFT_RECORD == RECORD_COUNTERS
+	job->events_array[run] = record->events;
+	job->assemblies_array[run] = record->assemblies;
+	job->disassemblies_array[run] = record->disassemblies;
+#endif
+	job->l_array[run] = record->length;
+	job->done[run] = 1;
+
+	printf("\nRun %4d complete.", ++(job->n_done));
+
+	/* Write everything done so far (fallback) */
+	while( job->prefix < job->n_runs && job->done[ job->prefix ] )
+		++(job->prefix);
+	if( job->prefix / 10 > before && (out = fopen( job->backup, "w" )) != NULL ){
+		fwrite( &(job->prefix), sizeof(unsigned int), 1, out);
+		fwrite( job->l_array, sizeof(int), job->prefix, out);
+		fclose( out );
+	}
+}
+
 void ift_ensemble(
    const Parameters * const p,
    const InitialConditions * const ic,
+   const Engine * const engine,
+   const Seeding * const seeding,
+   const unsigned interleave,
    const unsigned int n_runs,
    int l_array[],
-   int events_array[],
-   int assemblies_array[],
-   int disassemblies_array[],
+   int64_t events_array[],
+   int64_t assemblies_array[],
+   int64_t disassemblies_array[],
    const char * backup)
 /*void ift_ensemble( const Parameters * const p, const InitialConditions * const ic,
-	const unsigned int n_runs, int l_array[])
+	const Engine * const engine, const Seeding * const seeding,
+	const unsigned interleave, const unsigned int n_runs, int l_array[],
+	int64_t events_array[], int64_t assemblies_array[],
+	int64_t disassemblies_array[], const char * backup)
 
 Runs the IFT simulation repeatedly, recording only the lengths at time_limit for each run.
 
-backud - filename of backup file.
+backup - filename of backup file: the number of runs done and their lengths
+	are written to it every 10 runs (in binary).
  
 Input:
 p - The transport and disassembly rates (see comment on Parameters struct)
 ic - Simulation initial conditions (see comment on InitialConditions struct)
+engine - The simulation algorithm (see comment on Engine struct)
+seeding - How to seed the random number generator (see comment on Seeding struct)
+interleave - the number of runs stepped in turn (see interleave.c); 1 does
+	the runs one after the other.
 n_runs - the number of times to run the simulation.
 
 Output:
@@ -232,63 +792,69 @@ l_array - Array of lengths corresponding to the different runs.
 events_array - Array of event counts per run.
 assemblies_array - Array of assembly events per run.
 disassemblies_array - Array of disassembly events per run.
+	The counts are only recorded with RECORD_COUNTERS; with RECORD_FINAL
+	these three arrays are left alone and may be NULL.
 
 */
 {
-	FILE * out;
-	unsigned int i, j;
-
-	int length; /*Current flagellum length*/
-	int x[ic->n_ifts]; /*IFT positions*/
-	double t; /*Current time*/
-        int change; /*Change in length*/
-        int assembly_count, disassembly_count, event_count;
+	Interleave * il = interleave_create( engine, ic, interleave );
+	EnsembleJob job;
 
 	/*** Initialization ***/
+	ensemble_job( &job, n_runs, l_array, events_array, assemblies_array,
+		disassemblies_array, backup );
 
 	/* Random number generator seed */
-	seed();
-
+	interleave_seed( il, seeding, 0 );
 
 	/*** Main Loop ***/
-	for( i = 0; i < n_runs; ){
-
-	   /* Sets Initial positions of IFT's and lengths. */
-	   for( j = 0; j < ic->n_ifts; j++ ) x[j] = ic->x0[j];
-	   length = ic->length0;
-
-	   t = 0;
-           event_count = 0;
-           assembly_count = 0;
-           disassembly_count = 0;
-
-	   while( t < ic->time_limit ){
-              change = ift_step( p, ic->time_limit, &t, &length, x, ic->n_ifts );
-
-              if( change > 0 ) ++assembly_count;
-              if( change < 0 ) ++disassembly_count;
-              ++event_count;
-           }
+	interleave_runs( il, engine, p, ic, seeding, ensemble_take, ensemble_put,
+		&job );
 
+	printf("\nFinished.\n");
+	interleave_report( il, engine );
+	interleave_destroy( il, engine );
+	free( job.done );
 
-           events_array[i] = event_count;
-           assemblies_array[i] = assembly_count;
-           disassemblies_array[i] = disassembly_count;
-	   l_array[i] = length;
+	return;
+}
 
-	   ++i;
 
-	   /* Write backup * -- IGNORED
-	   if( i%10 == 0 && (out = fopen( backup, "w" )) != NULL ){
-	      fwrite( &i, sizeof(unsigned int), 1, out);
-	      fwrite( l_array, sizeof(int), i, out);
-	      fclose( out );
-	   }*/
-	   printf("\nRun %4d complete.", i);
-	}
+#if IFT_MOVE == MOVE_FREE
+#define LOCKSTEP_W 4
+#include "lockstep.c"
+#define LOCKSTEP_W 8
+#include "lockstep.c"
 
-	printf("\nFinished.\n");
-	return;
+void ift_ensemble_lockstep(
+   const Parameters * const p,
+   const InitialConditions * const ic,
+   const Seeding * const seeding,
+   const unsigned lanes,
+   const unsigned int n_runs,
+   int l_array[],
+   int64_t events_array[],
+   int64_t assemblies_array[],
+   int64_t disassemblies_array[],
+   const char * backup)
+/*void ift_ensemble_lockstep( const Parameters * const p,
+	const InitialConditions * const ic, const Seeding * const seeding,
+	const unsigned lanes, const unsigned int n_runs, int l_array[],
+	int64_t events_array[], int64_t assemblies_array[],
+	int64_t disassemblies_array[], const char * backup)
+
+Same as ift_ensemble with the grouped engine, but runs lanes (4 or 8) runs
+at a time in lockstep (see lockstep.c).  The runs finish out of order; the
+backup holds the runs complete before the first missing one.
+*/
+{
+	if( lanes == 8 )
+		ift_ensemble_lockstep_8( p, ic, seeding, n_runs, l_array,
+			events_array, assemblies_array, disassemblies_array, backup );
+	else
+		ift_ensemble_lockstep_4( p, ic, seeding, n_runs, l_array,
+			events_array, assemblies_array, disassemblies_array, backup );
 }
+#endif
 
 #endif
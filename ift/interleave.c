@@ -0,0 +1,181 @@
+/* Author: Yuriy Sverchkov
+   File: interleave.c
+   Description: Runs of an ensemble interleaved event by event.
+   A step of one run is a chain of dependent operations (draw, log, divide,
+   pick, update) that keeps the processor waiting on each result.  Steps of
+   independent runs do not depend on each other, so an Interleave holds k
+   runs, each with its own engine state and generator, and steps them round
+   robin: while one run's step waits on its log, the processor already
+   works on the next run's.  When a run reaches the time limit it is handed
+   over and the next run takes its place.  Works with any engine; with
+   fixed seeding every run is the same whatever k is.
+   Included by ift.c, after run.c.
+*/
+
+#ifndef INTERLEAVE_C_INCLUDED
+#define INTERLEAVE_C_INCLUDED
+
+typedef int (*TakeRun)( void * context, unsigned * run );
+/* Sets run to the next run to do and returns nonzero, or returns 0 if there
+   are none left. */
+typedef void (*PutRun)( void * context, const unsigned run,
+	const RunRecord * record );
+/* Receives the record of a finished run. */
+
+typedef struct{
+	unsigned k;
+	void ** state;
+	Rng ** rng;
+	double * t;
+	int * length;
+	unsigned * run;
+	short * active;
+	int64_t * events;
+	int64_t * assemblies;
+	int64_t * disassemblies;
+} Interleave;
+/*Interleave: Runs stepped in turn
+
+k - the number of runs stepped in turn.
+state, rng - each run's engine state and generator (kept from run to run).
+t, length - the time and length of each run.
+run - the index of each run.
+active - nonzero if the slot has a run.
+events, assemblies, disassemblies - each run's counts so far
+	(RECORD_COUNTERS).
+*/
+
+
+Interleave * interleave_create( const Engine * const engine,
+	const InitialConditions * const ic, const unsigned k )
+/* Allocates k slots (at least one) with engine states for ic. */
+{
+	Interleave * il = (Interleave *) malloc( sizeof(Interleave) );
+	unsigned i;
+
+	il->k = k > 0 ? k : 1;
+	il->state = (void **) malloc( il->k * sizeof(void *) );
+	il->rng = (Rng **) malloc( il->k * sizeof(Rng *) );
+	il->t = (double *) malloc( il->k * sizeof(double) );
+	il->length = (int *) malloc( il->k * sizeof(int) );
+	il->run = (unsigned *) malloc( il->k * sizeof(unsigned) );
+	il->active = (short *) malloc( il->k * sizeof(short) );
+	il->events = (int64_t *) malloc( il->k * sizeof(int64_t) );
+	il->assemblies = (int64_t *) malloc( il->k * sizeof(int64_t) );
+	il->disassemblies = (int64_t *) malloc( il->k * sizeof(int64_t) );
+
+	for( i = 0; i < il->k; i++ ){
+		il->state[i] = engine->create( ic );
+		il->rng[i] = rng_create();
+	}
+
+	return il;
+}
+
+void interleave_destroy( Interleave * il, const Engine * const engine ){
+
+	unsigned i;
+
+	for( i = 0; i < il->k; i++ ){
+		engine->destroy( il->state[i] );
+		rng_destroy( il->rng[i] );
+	}
+	free( il->state );
+	free( il->rng );
+	free( il->t );
+	free( il->length );
+	free( il->run );
+	free( il->active );
+	free( il->events );
+	free( il->assemblies );
+	free( il->disassemblies );
+	free( il );
+}
+
+void interleave_seed( Interleave * il, const Seeding * const seeding,
+	const unsigned stream )
+/* Seeds the generators with streams stream to stream+k-1 (see seed). */
+{
+	unsigned i;
+
+	for( i = 0; i < il->k; i++ )
+		seed( il->rng[i], seeding, stream + i );
+}
+
+static short interleave_start( Interleave * il, const unsigned i,
+	const Engine * const engine, const InitialConditions * const ic,
+	const Seeding * const seeding, TakeRun take, void * context )
+/* Puts the next run in slot i, if there is one.  Returns nonzero if so. */
+{
+	if( !( il->active[i] = take( context, &(il->run[i]) ) ) ) return 0;
+
+	seed_run( il->rng[i], seeding, il->run[i] );
+	engine->reset( il->state[i], ic );
+	il->t[i] = 0;
+	il->length[i] = ic->length0;
+	il->events[i] = il->assemblies[i] = il->disassemblies[i] = 0;
+	return 1;
+}
+
+void interleave_runs( Interleave * il, const Engine * const engine,
+	const Parameters * const p, const InitialConditions * const ic,
+	const Seeding * const seeding, TakeRun take, PutRun put, void * context )
+/* Does the runs take gives out, k at a time, and passes each one's record
+   (as IFT_RECORD says) to put as it finishes. */
+{
+	const double time_limit = ic->time_limit;
+	unsigned i, n_active = 0;
+	RunRecord record;
+#if IFT_RECORD == RECORD_COUNTERS
+	int change;
+	int64_t assemblies, disassemblies;
+#endif
+
+	for( i = 0; i < il->k; i++ )
+		n_active += interleave_start( il, i, engine, ic, seeding, take, context );
+
+	/*** Main Loop ***/
+	while( n_active > 0 )
+		for( i = 0; i < il->k; i++ ){
+
+			if( !il->active[i] ) continue;
+
+			if( il->t[i] < time_limit ){
+#if IFT_RECORD == RECORD_COUNTERS
+				change = engine->step( il->state[i], p, il->rng[i], time_limit,
+					&(il->t[i]), &(il->length[i]) );
+				if( engine->counts != NULL ){ /* A leap: change is net */
+					engine->counts( il->state[i], &assemblies, &disassemblies );
+					il->assemblies[i] += assemblies;
+					il->disassemblies[i] += disassemblies;
+				}else{
+					il->assemblies[i] += change > 0 ? change : 0;
+					il->disassemblies[i] += change < 0 ? -change : 0;
+				}
+				++(il->events[i]);
+#else
+				engine->step( il->state[i], p, il->rng[i], time_limit,
+					&(il->t[i]), &(il->length[i]) );
+#endif
+				if( il->t[i] < time_limit ) continue;
+			}
+
+			/* The run is over: hand it over and take the next one */
+			record.length = il->length[i];
+			record.events = il->events[i];
+			record.assemblies = il->assemblies[i];
+			record.disassemblies = il->disassemblies[i];
+			put( context, il->run[i], &record );
+
+			if( !interleave_start( il, i, engine, ic, seeding, take, context ) )
+				--n_active;
+		}
+}
+
+void interleave_report( const Interleave * il, const Engine * const engine )
+/* Has the engine report on the runs done so far (see Engine). */
+{
+	if( engine->report != NULL ) engine->report( il->state, il->k );
+}
+
+#endif
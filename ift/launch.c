@@ -0,0 +1,452 @@
+/* Author: Yuriy Sverchkov
+   Filename: launch.c
+   Purpose: What every front end of the simulation does around the runs:
+   reads the options, the parameters and the initial conditions, prints
+   them, and writes the results.  Included by the launchers after ift.c and
+   their print_usage; each one adds its own options (see LaunchOption) and
+   its way of running an ensemble (see RunEnsemble).
+*/
+
+#ifndef LAUNCH_C_INCLUDED
+#define LAUNCH_C_INCLUDED
+
+#include <string.h>
+
+/* Initial positions printed before the run; the rest are only counted */
+#define MAX_PRINTED 100
+
+typedef struct{
+   Parameters p;
+   InitialConditions ic;
+   const Engine * engine;
+   Seeding seeding;
+   unsigned interleave;
+   unsigned lanes;
+   short output_ascii;
+   FILE * outfile;
+   unsigned n_runs;
+   const char * backup;
+} Launch;
+/*Launch: What the command line asks for
+
+p, ic - the parameters and initial conditions read from the input files.
+engine - the engine to run (-e, or the first one that takes the IFTs'
+   speeds if they are given).
+seeding - how the generators are seeded (-g, -s, -r).
+interleave - the number of runs stepped in turn (-k).
+lanes - the number of runs in lockstep (-w), 0 if not asked for.
+output_ascii, outfile - the output file and its format.
+n_runs, backup - the runs of an ensemble and the backup file; backup is
+   NULL in trajectory mode.
+*/
+
+typedef int (*LaunchOption)( void * context, const char option,
+   const char * const value );
+/* A front end's own option, given as its letter and the argument after it.
+   Returns 1 if it took it, 0 if it is not one of its options, or -1 (having
+   said why) if the argument is wrong. */
+
+typedef void (*RunEnsemble)( void * context, const Launch * const l,
+   int l_array[], int64_t events_array[], int64_t assemblies_array[],
+   int64_t disassemblies_array[] );
+/* Runs the ensemble l asks for, with ift_ensemble's outputs. */
+
+#if IFT_MOVE == MOVE_EXCLUSION
+int pos_compare( const void * x1, const void * x2 )
+/* Compares two positions.
+   Prints out an error message if they are identical.
+   Returns *x1 - *x2
+*/
+{
+   const int * ix1 = (int *) x1;
+   const int * ix2 = (int *) x2;
+   int r = (*ix1 - *ix2);
+   if( r == 0 ) printf("\n!ERROR: Overlapping Positions!\n");
+   return r;
+}
+
+typedef struct{
+   int x;
+   double speed;
+} IftEntry;
+
+int entry_compare( const void * e1, const void * e2 ){
+   return pos_compare( &( ((const IftEntry *) e1)->x ),
+      &( ((const IftEntry *) e2)->x ) );
+}
+
+void sort_ifts( InitialConditions * ic )
+/* Sorts the IFTs by position, keeping each one's speed (if any) with it. */
+{
+   IftEntry * e;
+   unsigned i;
+
+   if( ic->speed == NULL ){
+      qsort( ic->x0, ic->n_ifts, sizeof(int), pos_compare );
+      return;
+   }
+
+   e = (IftEntry *) malloc( ( (size_t) ic->n_ifts + 1 ) * sizeof(IftEntry) );
+   for( i = 0; i < ic->n_ifts; i++ ){
+      e[i].x = ic->x0[i];
+      e[i].speed = ic->speed[i];
+   }
+   qsort( e, ic->n_ifts, sizeof(IftEntry), entry_compare );
+   for( i = 0; i < ic->n_ifts; i++ ){
+      ic->x0[i] = e[i].x;
+      ic->speed[i] = e[i].speed;
+   }
+   free( e );
+}
+#endif
+
+void launch_print( const Launch * const l )
+/* Prints the rates, the initial conditions and how they will be run. */
+{
+   const InitialConditions * const ic = &(l->ic);
+   unsigned i;
+
+   printf("\nRates:  lambda+ = %g  lambda- = %g  mu = %g\n",
+      l->p.lambda_p, l->p.lambda_m, l->p.mu );
+   printf("\nInitial Conditions:\n");
+   printf("\n-Initial Length: %d", ic->length0);
+   printf("\n-Initial Positions:");
+   for( i=0; i < ic->n_ifts && i < MAX_PRINTED; i++ ) printf(" %d",ic->x0[i]);
+   if( ic->n_ifts > MAX_PRINTED ) printf(" ... (%u IFTs)", ic->n_ifts);
+   if( ic->speed != NULL ){
+      printf("\n-Speeds:");
+      for( i=0; i < ic->n_ifts && i < MAX_PRINTED; i++ ) printf(" %g",ic->speed[i]);
+      if( ic->n_ifts > MAX_PRINTED ) printf(" ...");
+   }
+   printf("\n-Time Limit: %f\n", ic->time_limit);
+   if( l->lanes )
+      printf("\nEngine: grouped, %u runs in lockstep (ensembles)\n", l->lanes);
+   else
+      printf("\nEngine: %s\n", l->engine->name);
+   if( l->interleave > 1 )
+      printf("Runs stepped in turn: %u (ensembles)\n", l->interleave);
+   if( l->seeding.fixed )
+      printf("Seed: %lu, first run: %lu\n", l->seeding.seed, l->seeding.first_run);
+   else if( l->seeding.generator == RNG_DSFMT )
+      printf("Generator: dsfmt\n");
+   else
+      printf("Generator: sfmt, period 2^%d-1\n",
+         ( l->seeding.period ? l->seeding.period : RNG_DEFAULT_PERIOD )->mexp);
+}
+
+int launch_read( Launch * const l, int argc, char* argv[],
+   const short lockstep, LaunchOption option, void * context )
+/* Reads the command line into l, opening the output file, and prints what
+   it asks for.  -w is only taken if lockstep is nonzero; options other than
+   the common ones go to option (if not NULL) with context.
+   Returns 0, or the exit status after saying what is wrong. */
+{
+   /*Other Variables*/
+   short engine_set = 0;
+   int taken = 0;
+   unsigned i;
+   float f_lambda_p, f_lambda_m, f_mu;
+   FILE * inparameters;
+   FILE * infile;
+   Parameters * const p = &(l->p);
+   InitialConditions * const ic = &(l->ic);
+
+   l->engine = engines[0];
+   l->seeding.fixed = 0;
+   l->seeding.seed = l->seeding.first_run = 0;
+   l->seeding.generator = RNG_DEFAULT;
+   l->seeding.period = NULL;
+   l->interleave = 1;
+   l->lanes = 0;
+
+#if IFT_MOVE == MOVE_EXCLUSION
+   printf("IFT Simulation 0.2\n");
+#else
+   printf("IFT Simulation 0.1\n");
+#endif
+
+   /* Error checking for the impossible */
+   if( argc <= 0 ) return 1;
+
+   /* The vector instructions to use, picked before any thread starts */
+   ift_dispatch();
+
+   /* Options preceding the file arguments */
+   while( argc > 2 && argv[1][0] == '-' && argv[1][1] != '\0'
+      && argv[1][2] == '\0' && strchr( "ab", argv[1][1] ) == NULL ){
+
+      if( argv[1][1] == 'w' && lockstep ){
+         l->lanes = strtoul( argv[2], NULL, 0 );
+#if IFT_MOVE == MOVE_FREE
+         if( l->lanes != 4 && l->lanes != 8 ){
+#else
+         {
+#endif
+            printf( "Cannot run %s lanes in lockstep.\n", argv[2] );
+            print_usage( argv[0] );
+            return 1;
+         }
+      }
+
+      else if( argv[1][1] == 'k' ){
+         if( ( l->interleave = strtoul( argv[2], NULL, 0 ) ) < 1 ){
+            printf( "Cannot step %s runs in turn.\n", argv[2] );
+            print_usage( argv[0] );
+            return 1;
+         }
+      }
+
+      else if( argv[1][1] == 's' ){
+         l->seeding.fixed = 1;
+         l->seeding.seed = strtoul( argv[2], NULL, 0 );
+      }
+
+      else if( argv[1][1] == 'r' )
+         l->seeding.first_run = strtoul( argv[2], NULL, 0 );
+
+      else if( argv[1][1] == 'g' ){
+         if( strcmp( argv[2], "sfmt" ) == 0 ){
+            l->seeding.generator = RNG_SFMT;
+            l->seeding.period = NULL;
+         }
+         else if( strncmp( argv[2], "sfmt", 4 ) == 0
+            && ( l->seeding.period = rng_find_period( atoi( argv[2] + 4 ) ) ) )
+            l->seeding.generator = RNG_SFMT;
+         else if( strcmp( argv[2], "dsfmt" ) == 0 ) l->seeding.generator = RNG_DSFMT;
+         else{
+            printf( "Unknown generator %s.\n", argv[2] );
+            print_usage( argv[0] );
+            return 1;
+         }
+      }
+
+      else if( argv[1][1] == 'e' ){
+         if( ( l->engine = find_engine( argv[2] ) ) == NULL ){
+            printf( "Unknown engine %s.\n", argv[2] );
+            print_usage( argv[0] );
+            return 1;
+         }
+         engine_set = 1;
+      }
+
+      /* The front end's own */
+      else if( option == NULL
+         || ( taken = option( context, argv[1][1], argv[2] ) ) == 0 )
+         break;
+      else if( taken < 0 ){
+         print_usage( argv[0] );
+         return 1;
+      }
+
+      /* Drop the option, keeping the program name in argv[0] */
+      argv[2] = argv[0];
+      argv += 2;
+      argc -= 2;
+   }
+
+   if( l->lanes && l->interleave > 1 ){
+      printf( "Cannot step runs in turn (-k) while running them in lockstep (-w).\n" );
+      print_usage( argv[0] );
+      return 1;
+   }
+
+   /* Error checking for incorrect call */
+   if( argc != 8 && argc != 10 ) {
+      print_usage( argv[0] );
+      return 1;
+   }
+
+   /* Opening files */
+   if( ( inparameters = fopen( argv[2], "r" ) ) == NULL ){
+      printf( "Cannot open %s.\n", argv[2] );
+      return 1;
+   }
+
+   if( ( infile = fopen( argv[4], "r" ) ) == NULL ){
+      printf( "Cannot open %s.\n", argv[4] );
+      fclose( inparameters );
+      return 1;
+   }
+
+   if( ( l->outfile = fopen( argv[7], "w" ) ) == NULL ){
+      printf( "Cannot open %s.\n", argv[7] );
+      fclose( inparameters );
+      fclose( infile );
+      return 1;
+   }
+
+   /* Get parameters and initial conditions */
+
+   if( strcmp( argv[1], "-a" ) == 0 ){
+
+      /* fscanf wants floats... */
+      fscanf( inparameters, "%g", &f_lambda_p );
+      fscanf( inparameters, "%g", &f_lambda_m );
+      fscanf( inparameters, "%g", &f_mu );
+      p->lambda_p = f_lambda_p;
+      p->lambda_m = f_lambda_m;
+      p->mu = f_mu;
+
+   }else if( strcmp( argv[1], "-b" ) == 0 ){
+
+      fread( &(p->lambda_p), sizeof(double), 1, inparameters );
+      fread( &(p->lambda_m), sizeof(double), 1, inparameters );
+      fread( &(p->mu), sizeof(double), 1, inparameters );
+
+   }else{
+
+      print_usage( argv[0] );
+      return 1;
+   }
+
+   if( strcmp( argv[3], "-a" ) == 0 ){
+
+      fscanf( infile, "%d", &(ic->length0) );
+      fscanf( infile, "%u", &(ic->n_ifts) );
+
+      ic->x0 = (int *) malloc( ( (size_t) ic->n_ifts + 1 ) * sizeof(int) );
+
+      for( i = 0; i < ic->n_ifts; i++ )
+         fscanf( infile, "%d", &(ic->x0[i]) );
+
+      /* Optional speeds */
+      ic->speed = (double *) malloc( ( (size_t) ic->n_ifts + 1 ) * sizeof(double) );
+      for( i = 0; i < ic->n_ifts && fscanf( infile, "%lf", &(ic->speed[i]) ) == 1; i++ );
+
+   }else if( strcmp( argv[3], "-b" ) == 0 ){
+
+      fread( &(ic->length0), sizeof(int), 1, infile );
+      fread( &(ic->n_ifts), sizeof(unsigned), 1, infile );
+
+      ic->x0 = (int *) malloc( ( (size_t) ic->n_ifts + 1 ) * sizeof(int) );
+
+      fread( ic->x0, sizeof(int), ic->n_ifts, infile );
+
+      /* Optional speeds */
+      ic->speed = (double *) malloc( ( (size_t) ic->n_ifts + 1 ) * sizeof(double) );
+      i = fread( ic->speed, sizeof(double), ic->n_ifts, infile );
+
+   }else{
+
+      print_usage( argv[0] );
+      return 1;
+   }
+
+   if( i < ic->n_ifts || ic->n_ifts == 0 ){
+      if( i > 0 ) printf( "Speeds given for %u of %u IFTs, ignored.\n", i, ic->n_ifts );
+      free( ic->speed );
+      ic->speed = NULL;
+   }
+
+   /* Fall back on an engine that takes speeds if none was asked for */
+   if( ic->speed != NULL && l->lanes ){
+      printf( "Lockstep lanes do not take IFT speeds.\n" );
+      return 1;
+   }
+   if( ic->speed != NULL && !l->engine->speeds ){
+      if( engine_set ){
+         printf( "Engine %s does not take IFT speeds.\n", l->engine->name );
+         return 1;
+      }
+      for( i = 0; !engines[i]->speeds; i++ );
+      l->engine = engines[i];
+   }
+
+   ic->time_limit = strtod( argv[5], NULL );
+
+   /* Determine output format */
+   if( strcmp( argv[6], "-a" ) == 0 ){
+      l->output_ascii = 1;
+   }else if( strcmp( argv[6], "-b" ) == 0 ){
+      l->output_ascii = 0;
+   }else{
+      print_usage( argv[0] );
+      return 1;
+   }
+
+   /* Ensemble mode if 'runs' is given, trajectory mode if not */
+   l->n_runs = argc == 10 ? strtoul( argv[8], NULL, 0 ) : 0;
+   l->backup = argc == 10 ? argv[9] : NULL;
+
+#if IFT_MOVE == MOVE_EXCLUSION
+   /* The exclusion rule keeps the IFTs in order around the ring */
+   sort_ifts( ic );
+#endif
+
+   /* Close input files */
+   fclose( inparameters );
+   fclose( infile );
+
+   launch_print( l );
+   return 0;
+}
+
+void launch_run( const Launch * const l, RunEnsemble run, void * context )
+/* Runs what l asks for, an ensemble by run (with context), and writes the
+   results to the output file. */
+{
+   /*Variables to store simulation output*/
+   DoubleArray t_array;
+   IntArray l_array;
+   int64_t * ecounts, * acounts, * dcounts;
+   unsigned i;
+
+   /* For running in trajectory mode */
+   if( l->backup == NULL ){
+
+      ift_trajectory( &(l->p), &(l->ic), l->engine, &(l->seeding), &t_array, &l_array );
+
+      /* Write to output file */
+      if( l->output_ascii )
+
+         for( i = 0; i < t_array.length && i < l_array.length; i++ )
+            fprintf( l->outfile, "%25.15e %10d\n",
+               daGet( t_array, i ), iaGet( l_array, i ) );
+
+      else{
+
+         fwrite( &t_array.length, sizeof(unsigned int), 1, l->outfile);
+         fwrite( t_array.contents, sizeof(double), t_array.length, l->outfile);
+         fwrite( &l_array.length, sizeof(unsigned int), 1, l->outfile);
+         fwrite( l_array.contents, sizeof(int), l_array.length, l->outfile);
+      }
+
+      iaDestroy( l_array );
+      daDestroy( t_array );
+      return;
+   }
+
+   /* For running in ensemble mode */
+   l_array = iaCreate( NULL, l->n_runs );
+   ecounts = (int64_t *) calloc( l->n_runs + 1, sizeof(int64_t) );
+   acounts = (int64_t *) calloc( l->n_runs + 1, sizeof(int64_t) );
+   dcounts = (int64_t *) calloc( l->n_runs + 1, sizeof(int64_t) );
+
+   run( context, l, l_array.contents, ecounts, acounts, dcounts );
+
+   /* Write to output file */
+   if( l->output_ascii ){
+#if IFT_RECORD == RECORD_COUNTERS
+         fprintf( l->outfile, "Length    \tEvents    \tAssemblies\tDisassemblies\n" );
+
+      for( i = 0; i < l_array.length; i++ )
+         fprintf( l->outfile, "%10d\t%10" PRId64 "\t%10" PRId64 "\t%10" PRId64 "\n",
+            iaGet( l_array, i ), ecounts[i], acounts[i], dcounts[i] );
+#else
+      for( i = 0; i < l_array.length; i++ )
+         fprintf( l->outfile, "%10d\n", iaGet( l_array, i ) );
+#endif
+
+   }else{
+
+      fwrite( &l_array.length, sizeof(unsigned int), 1, l->outfile);
+      fwrite( l_array.contents, sizeof(int), l_array.length, l->outfile);
+   }
+
+   iaDestroy( l_array );
+   free( ecounts );
+   free( acounts );
+   free( dcounts );
+}
+
+#endif
@@ -1,14 +1,17 @@
 /* Author: Yuriy Sverchkov
    Filename: launcher-threaded.c
-   See usage message for description. 
+   See usage message for description.  The threaded front end: only -j and
+   running an ensemble on the worker pool differ from launcher.c, the rest
+   is in launch.c.
 */
 
-#include "string.h"
 #include "ift-threaded.c"
 
 void print_usage( const char * const name ){
+	unsigned i;
+
 	printf(
-"Usage: %s -a|b parameters -a|b input time -a|b output [runs backup]\n\n\
+"Usage: %s [-e engine] [-j threads] [-k K] [-g generator] [-s seed [-r run]] -a|b parameters -a|b input time -a|b output [runs backup]\n\n\
 Where 'parameters' is the name of the file containing the simulation\n\
 parameters, 'input' is the name of the file containing the initial\n\
 conditions, 'time' is the simulation time limit (in seconds), 'output' is\n\
@@ -17,188 +20,66 @@ of times to run the simulation.\n\n\
 The simulation will run in 'ensemble' mode if 'runs' is specified, and in\n\
 'trajectory' mode if it is not.\n\
 If 'runs' is specified, then so must 'backup' be specified - a file to store\n\
-temporary results (those will be stored in binary format).\n\n\
+temporary results (those will be stored in binary format).\n\
+The positions in 'input' may be followed by a speed for each IFT, which\n\
+multiplies its rates (see ic/README.txt); only some engines take speeds.\n\n\
 -a \tspecifies that the file that follows is an ascii file.\n\
--b \tspecified that the file that follows is a binary file.\n"
-, name );
+-b \tspecified that the file that follows is a binary file.\n\
+-j \tsets the number of threads for 'ensemble' mode (default: one per\n\
+\tonline processor).\n\
+-k \tsteps K runs of an ensemble per thread in turn, event by event\n\
+\t(default: 1), so the processor overlaps their independent work.\n\
+-g \tselects the generator seeded from the clock: sfmt (32-bit integers,\n\
+\tthe default), sfmt followed by a Mersenne exponent for another period\n\
+\tthan 2^%d-1 (sfmt607 to sfmt216091), or dsfmt (doubles with 52 random\n\
+\tbits).\n\
+-s \tgives every run its own reproducible random number stream, keyed by\n\
+\tthe seed and numbered by the run index (default: seed from the clock).\n\
+-r \tsets the index of the first run with -s (default: 0), so a run can be\n\
+\trepeated alone, or an ensemble split into jobs.\n\
+-e \tselects the simulation engine, one of:"
+, name, RNG_DEFAULT_PERIOD->mexp );
+	for( i = 0; engines[i] != NULL; i++ )
+		printf( " %s%s", engines[i]->name, i == 0 ? " (default)" : "" );
+	printf( "\n" );
 	return;
 }
 
-int main( int argc, char* argv[]){
-
-   /*Stores simulation parameters*/
-   Parameters p;
-
-   /*Variables to store simulation output*/
-   DoubleArray t_array;
-   IntArray l_array;
-
-   /*Variables to represent simulation input*/
-   InitialConditions ic;
-   unsigned n_runs;
-
-   /*Other Variables*/
-   unsigned i;
-   short output_ascii;
-   float f_lambda_p, f_lambda_m, f_mu;
-   FILE * inparameters;
-   FILE * infile;
-   FILE * outfile;
-	
-   printf("IFT Simulation 0.1\n");
-
-   /* Error checking for the impossible */
-   if( argc <= 0 ) return 1;
-
-   /* Error checking for incorrect call */
-   if( argc < 8 ) {
-      print_usage( argv[0] );
-      return 1;
-   }
-
-   /* Opening files */
-   if( ( inparameters = fopen( argv[2], "r" ) ) == NULL ){
-      printf( "Cannot open %s.\n", argv[2] );
-      return 1;
-   }
-
-   if( ( infile = fopen( argv[4], "r" ) ) == NULL ){
-      printf( "Cannot open %s.\n", argv[4] );
-      fclose( inparameters );
-      return 1;
-   }
-
-   if( ( outfile = fopen( argv[7], "w" ) ) == NULL ){
-      printf( "Cannot open %s.\n", argv[7] );
-      fclose( inparameters );
-      fclose( infile );
-      return 1;
-   }
-
-   /* Get parameters and initial conditions */
-
-   if( strcmp( argv[1], "-a" ) == 0 ){
-
-      /* fscanf wants floats... */	
-      fscanf( inparameters, "%g", &f_lambda_p );
-      fscanf( inparameters, "%g", &f_lambda_m );
-      fscanf( inparameters, "%g", &f_mu );
-      p.lambda_p = f_lambda_p;
-      p.lambda_m = f_lambda_m;
-      p.mu = f_mu;
-	
-   }else if( strcmp( argv[1], "-b" ) == 0 ){
-		
-      fread( &(p.lambda_p), sizeof(double), 1, inparameters );
-      fread( &(p.lambda_m), sizeof(double), 1, inparameters );
-      fread( &(p.mu), sizeof(double), 1, inparameters );
-
-   }else{
-	
-      print_usage( argv[0] );
-      return 1;
-   }
-
-   if( strcmp( argv[3], "-a" ) == 0 ){
-
-      fscanf( infile, "%d", &(ic.length0) );
-      fscanf( infile, "%d", &(ic.n_ifts) );
+#include "launch.c"
 
-      ic.x0 = (int *) malloc( ic.n_ifts * sizeof(int) );
+int threads_option( void * context, const char option, const char * const value )
+/* Takes -j (see LaunchOption). */
+{
+   long * n_threads = context;
 
-      for( i = 0; i < ic.n_ifts; i++ )
-         fscanf( infile, "%d", &(ic.x0[i]) );
-
-   }else if( strcmp( argv[3], "-b" ) == 0 ){
-
-      fread( &(ic.length0), sizeof(int), 1, infile );
-      fread( &(ic.n_ifts), sizeof(int), 1, infile );
-
-      ic.x0 = (int *) malloc( ic.n_ifts * sizeof(int) );
-
-      fread( ic.x0, sizeof(int), ic.n_ifts, infile );
-	
-   }else{
-	
-      print_usage( argv[0] );
-      return 1;
-   }
-
-   ic.time_limit = strtod( argv[5], NULL );
-
-   /* Determine output format */
-   if( strcmp( argv[6], "-a" ) == 0 ){
-      output_ascii = 1;
-   }else if( strcmp( argv[6], "-b" ) == 0 ){
-      output_ascii = 0;
-   }else{
-      print_usage( argv[0] );
-      return 1;
-   }
-	
-   /* Close input files */
-   fclose( inparameters );
-   fclose( infile );
-
-   /* Print the rates and initial conditions */
-   printf("\nRates:  lambda+ = %g  lambda- = %g  mu = %g\n",
-      p.lambda_p, p.lambda_m, p.mu );
-   printf("\nInitial Conditions:\n");
-   printf("\n-Initial Length: %d", ic.length0);
-   printf("\n-Initial Positions:");
-   for( i=0; i < ic.n_ifts; i++ ) printf(" %d",ic.x0[i]);
-   printf("\n-Time Limit: %f\n", ic.time_limit);
-
-   /* For running in trajectory mode */
-   if( argc == 8 ){
-
-      ift_trajectory( &p, &ic, &t_array, &l_array );
-
-      /* Write to output file */
-      if( output_ascii )
-		
-         for( i = 0; i < t_array.length && i < l_array.length; i++ )
-            fprintf( outfile, "%25.15e %10d\n",
-               daGet( t_array, i ), iaGet( l_array, i ) );
-		
-      else{
-			
-         fwrite( &t_array.length, sizeof(unsigned int), 1, outfile);
-         fwrite( t_array.contents, sizeof(double), t_array.length, outfile);
-         fwrite( &l_array.length, sizeof(unsigned int), 1, outfile);
-         fwrite( l_array.contents, sizeof(int), l_array.length, outfile);
-      }
-
-      iaDestroy( l_array );
-      daDestroy( t_array );
-      return 0;
-   }
-
-   /* For running in ensemble mode */
-   if( argc == 10 ){
-
-      n_runs = atoi( argv[8] );
-
-      l_array = iaCreate( NULL, n_runs );
+   if( option != 'j' ) return 0;
+   *n_threads = atol( value );
+   if( *n_threads < 1 ) *n_threads = 1;
+   return 1;
+}
 
-      ift_ensemble( &p, &ic, n_runs, l_array.contents, argv[9] );
+void run_threaded( void * context, const Launch * const l, int l_array[],
+   int64_t events_array[], int64_t assemblies_array[],
+   int64_t disassemblies_array[] )
+/* Runs the ensemble on a pool of context's number of threads. */
+{
+   const long n_threads = *(long *) context;
+   WorkerPool * pool;
+
+   printf("\nThreads: %ld\n", n_threads);
+   pool = pool_create( n_threads, l->engine, &(l->ic), l->interleave );
+   ift_ensemble_threaded( &(l->p), pool, &(l->seeding), l->n_runs,
+      l_array, events_array, assemblies_array, disassemblies_array, l->backup );
+   pool_destroy( pool );
+}
 
-      /* Write to output file */
-      if( output_ascii )
-	
-         for( i = 0; i < l_array.length; i++ )
-            fprintf( outfile, "%10d\n", iaGet( l_array, i ) );
-		
-      else{
+int main( int argc, char* argv[]){
 
-         fwrite( &l_array.length, sizeof(unsigned int), 1, outfile);
-         fwrite( l_array.contents, sizeof(int), l_array.length, outfile);
-      }
-	
-      iaDestroy( l_array );
-      return 0;
-   }
+   Launch l;
+   long n_threads = sysconf( _SC_NPROCESSORS_ONLN );
 
-   print_usage(argv[0]);
+   if( n_threads < 1 ) n_threads = 1;
+   if( launch_read( &l, argc, argv, 0, threads_option, &n_threads ) != 0 ) return 1;
+   launch_run( &l, run_threaded, &n_threads );
    return 0;
 }
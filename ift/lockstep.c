@@ -0,0 +1,276 @@
+/* Author: Yuriy Sverchkov
+   File: lockstep.c
+   Description: Ensembles run LOCKSTEP_W replicas at a time, as a template.
+   ift.c includes this file once per width (4 and 8) for the free movement
+   rule, after defining LOCKSTEP_W.  The replicas ("lanes") advance in
+   lockstep, one event each per iteration, with the grouped engine's
+   algorithm.  Their lengths, times, class counts and random draws are kept
+   in arrays of LOCKSTEP_W, struct-of-arrays fashion.  The rates, waiting
+   times, time limit test and choice of the event class are computed for
+   all lanes at once, two per SSE2 vector, with masks in place of branches.
+   Only picking the IFT and moving it is done lane by lane.  A lane that
+   reaches time_limit records its run and starts the next one, so lanes stay
+   busy until the runs run out; lanes left without a run are masked off.
+   Each lane draws the same numbers in the same order as grouped_step, so
+   with fixed seeding run i is the same as with the grouped engine.
+   The macros are undefined at the end.
+*/
+
+#define LOCKSTEP_NAME( f ) RNG_PASTE( f, LOCKSTEP_W )
+
+/* Event classes of a lane in an iteration */
+#ifndef LOCKSTEP_ANTE
+#define LOCKSTEP_ANTE 0
+#define LOCKSTEP_RETRO 1
+#define LOCKSTEP_DISASSEMBLY 2
+#define LOCKSTEP_DONE 3
+
+#if defined(HAVE_SSE2)
+/* m ? a : b, lane by lane, for a mask m of all ones or all zeros */
+#define LOCKSTEP_BLEND( m, a, b ) \
+	_mm_or_pd( _mm_and_pd( (m), (a) ), _mm_andnot_pd( (m), (b) ) )
+#endif
+#endif
+
+typedef struct{
+	double t[LOCKSTEP_W];
+	double length[LOCKSTEP_W];
+	double n_ante[LOCKSTEP_W];
+	double n_retro[LOCKSTEP_W];
+	double wait[LOCKSTEP_W];
+	double u[LOCKSTEP_W];
+	double pick[LOCKSTEP_W];
+	double kind[LOCKSTEP_W];
+	int active[LOCKSTEP_W];
+	unsigned run[LOCKSTEP_W];
+	int64_t events[LOCKSTEP_W];
+	int64_t assemblies[LOCKSTEP_W];
+	int64_t disassemblies[LOCKSTEP_W];
+	Rng * rng[LOCKSTEP_W];
+	GroupedState * state[LOCKSTEP_W];
+} LOCKSTEP_NAME( Lanes );
+/*Lanes: The replicas advanced together
+
+t, length - the time and length of each lane (lengths as doubles, for the
+	vector loop).
+n_ante, n_retro - the number of anterograde and retrograde IFTs.
+wait, u - the iteration's exponential and uniform draws.
+pick - where in its class the event falls, in [0,1).
+kind - the iteration's event class (LOCKSTEP_ANTE to LOCKSTEP_DONE, as a
+	double so that it is computed with the rest).
+active - nonzero if the lane has a run.
+run - the index of the lane's run.
+events, assemblies, disassemblies - the run's counts so far.
+rng, state - each lane's generator and grouped engine state.
+*/
+
+
+static void LOCKSTEP_NAME( lockstep_start_ )( LOCKSTEP_NAME( Lanes ) * l,
+	const unsigned w, const unsigned run,
+	const InitialConditions * const ic, const Seeding * const seeding )
+/* Starts run on lane w. */
+{
+	seed_run( l->rng[w], seeding, run );
+	grouped_reset( l->state[w], ic );
+
+	l->active[w] = 1;
+	l->run[w] = run;
+	l->t[w] = 0;
+	l->length[w] = ic->length0;
+	l->n_ante[w] = l->state[w]->ante.size;
+	l->n_retro[w] = l->state[w]->retro.size;
+	l->events[w] = l->assemblies[w] = l->disassemblies[w] = 0;
+}
+
+static void LOCKSTEP_NAME( lockstep_event_ )( LOCKSTEP_NAME( Lanes ) * l,
+	const unsigned w )
+/* Carries out lane w's event, once its class and pick are known. */
+{
+	GroupedState * s = l->state[w];
+	int length = (int) l->length[w];
+	unsigned i, j;
+
+	switch( (int) l->kind[w] ){
+
+	case LOCKSTEP_ANTE:
+		j = idsPick( &(s->ante), l->pick[w] );
+
+		if( ++(s->x[j]) > length ){ /* Then assembly occurs */
+			++length;
+			++(l->assemblies[w]);
+			s->x[j] = -length;
+			idsRemove( &(s->ante), j );
+			idsInsert( &(s->retro), j );
+		}
+		break;
+
+	case LOCKSTEP_RETRO:
+		j = idsPick( &(s->retro), l->pick[w] );
+
+		if( ++(s->x[j]) == 0 ){ /* Reached the base */
+			idsRemove( &(s->retro), j );
+			idsInsert( &(s->ante), j );
+		}
+		break;
+
+	case LOCKSTEP_DISASSEMBLY:
+		--length;
+		++(l->disassemblies[w]);
+
+		/* Move IFTs on Disassembled segment down. */
+		for( i = 0; i < s->n_ifts; i++ )
+			if( s->x[i] == length+1 )
+				--(s->x[i]);
+			else if( s->x[i] == -length-1 && ++(s->x[i]) == 0 ){
+				idsRemove( &(s->retro), i );
+				idsInsert( &(s->ante), i );
+			}
+		break;
+	}
+
+	l->length[w] = length;
+	l->n_ante[w] = s->ante.size;
+	l->n_retro[w] = s->retro.size;
+}
+
+void LOCKSTEP_NAME( ift_ensemble_lockstep_ )(
+	const Parameters * const p,
+	const InitialConditions * const ic,
+	const Seeding * const seeding,
+	const unsigned int n_runs,
+	int l_array[],
+	int64_t events_array[],
+	int64_t assemblies_array[],
+	int64_t disassemblies_array[],
+	const char * backup)
+/* Same as ift_ensemble with the grouped engine (see ift_ensemble_lockstep). */
+{
+	LOCKSTEP_NAME( Lanes ) * l = (LOCKSTEP_NAME( Lanes ) *)
+		cache_alloc( sizeof( LOCKSTEP_NAME( Lanes ) ) );
+	const double time_limit = ic->time_limit;
+	EnsembleJob job;
+	RunRecord record;
+	unsigned w, run, n_active = 0;
+#if defined(HAVE_SSE2)
+	const __m128d lambda_p = _mm_set1_pd( p->lambda_p );
+	const __m128d lambda_m = _mm_set1_pd( p->lambda_m );
+	const __m128d mu = _mm_set1_pd( p->mu );
+	const __m128d limit = _mm_set1_pd( time_limit );
+	const __m128d zero = _mm_setzero_pd();
+	__m128d ante_rate, retro_rate, rate_sum, t, temp, rest, in_time,
+		is_ante, is_retro;
+#else
+	double ante_rate, retro_rate, rate_sum, t, temp;
+#endif
+
+	ensemble_job( &job, n_runs, l_array, events_array, assemblies_array,
+		disassemblies_array, backup );
+
+	for( w = 0; w < LOCKSTEP_W; w++ ){
+		l->rng[w] = rng_create();
+		l->state[w] = (GroupedState *) grouped_create( ic );
+		seed( l->rng[w], seeding, w );
+
+		if( ensemble_take( &job, &run ) ){
+			LOCKSTEP_NAME( lockstep_start_ )( l, w, run, ic, seeding );
+			++n_active;
+		}else
+			l->active[w] = 0;
+	}
+
+	/*** Main Loop ***/
+	while( n_active > 0 ){
+
+		/* Each lane's draws, from its own generator */
+		for( w = 0; w < LOCKSTEP_W; w++ )
+			if( l->active[w] ){
+				l->wait[w] = ift_wait( l->rng[w] );
+				l->u[w] = rng_uniform( l->rng[w] );
+			}else
+				l->wait[w] = l->u[w] = 0;
+
+		/* Rates, times and event classes of all lanes at once (inactive
+		   lanes compute something and are ignored) */
+#if defined(HAVE_SSE2)
+		for( w = 0; w < LOCKSTEP_W; w += 2 ){
+			ante_rate = _mm_mul_pd( lambda_p, _mm_load_pd( l->n_ante + w ) );
+			retro_rate = _mm_mul_pd( lambda_m, _mm_load_pd( l->n_retro + w ) );
+			rate_sum = _mm_add_pd( _mm_add_pd( ante_rate, retro_rate ),
+				_mm_and_pd( _mm_cmpgt_pd( _mm_load_pd( l->length + w ), zero ), mu ) );
+			t = _mm_add_pd( _mm_load_pd( l->t + w ),
+				_mm_div_pd( _mm_load_pd( l->wait + w ), rate_sum ) );
+			temp = _mm_mul_pd( rate_sum, _mm_load_pd( l->u + w ) );
+			rest = _mm_sub_pd( temp, ante_rate );
+
+			in_time = _mm_cmple_pd( t, limit );
+			is_ante = _mm_cmplt_pd( temp, ante_rate );
+			is_retro = _mm_cmplt_pd( rest, retro_rate );
+
+			_mm_store_pd( l->kind + w, LOCKSTEP_BLEND( in_time,
+				LOCKSTEP_BLEND( is_ante, _mm_set1_pd( LOCKSTEP_ANTE ),
+				LOCKSTEP_BLEND( is_retro, _mm_set1_pd( LOCKSTEP_RETRO ),
+					_mm_set1_pd( LOCKSTEP_DISASSEMBLY ) ) ),
+				_mm_set1_pd( LOCKSTEP_DONE ) ) );
+			_mm_store_pd( l->pick + w, LOCKSTEP_BLEND( is_ante,
+				_mm_div_pd( temp, ante_rate ), _mm_div_pd( rest, retro_rate ) ) );
+			_mm_store_pd( l->t + w, LOCKSTEP_BLEND( in_time, t, limit ) );
+		}
+#else
+		for( w = 0; w < LOCKSTEP_W; w++ ){
+			ante_rate = p->lambda_p * l->n_ante[w];
+			retro_rate = p->lambda_m * l->n_retro[w];
+			rate_sum = ante_rate + retro_rate + ( l->length[w] > 0 ? p->mu : 0 );
+			t = l->t[w] + l->wait[w] / rate_sum;
+			temp = rate_sum * l->u[w];
+
+			l->kind[w] = !( t <= time_limit ) ? LOCKSTEP_DONE
+				: temp < ante_rate ? LOCKSTEP_ANTE
+				: temp - ante_rate < retro_rate ? LOCKSTEP_RETRO
+				: LOCKSTEP_DISASSEMBLY;
+			l->pick[w] = temp < ante_rate ? temp / ante_rate
+				: ( temp - ante_rate ) / retro_rate;
+			l->t[w] = t <= time_limit ? t : time_limit;
+		}
+#endif
+
+		/* The events, lane by lane */
+		for( w = 0; w < LOCKSTEP_W; w++ ){
+
+			if( !l->active[w] ) continue;
+
+			++(l->events[w]);
+
+			if( l->kind[w] != LOCKSTEP_DONE ){
+				LOCKSTEP_NAME( lockstep_event_ )( l, w );
+				continue;
+			}
+
+			/* The run is over: record it and take the next one */
+			record.length = (int) l->length[w];
+			record.events = l->events[w];
+			record.assemblies = l->assemblies[w];
+			record.disassemblies = l->disassemblies[w];
+			ensemble_put( &job, l->run[w], &record );
+
+			if( ensemble_take( &job, &run ) )
+				LOCKSTEP_NAME( lockstep_start_ )( l, w, run, ic, seeding );
+			else{
+				l->active[w] = 0;
+				--n_active;
+			}
+		}
+	}
+
+	for( w = 0; w < LOCKSTEP_W; w++ ){
+		grouped_destroy( l->state[w] );
+		rng_destroy( l->rng[w] );
+	}
+	cache_free( l );
+	free( job.done );
+
+	printf("\nFinished.\n");
+	return;
+}
+
+#undef LOCKSTEP_NAME
+#undef LOCKSTEP_W
@@ -0,0 +1,77 @@
+/* Author: Yuriy Sverchkov
+   Filename: mkziggurat.c
+   Purpose: Writes ziggurat.h, the tables of the ziggurat sampler for the
+   exponential distribution used by randist.c (Marsaglia and Tsang, 2000,
+   with 256 layers).  The layer is picked with the low 8 bits of a 32-bit
+   random word and the position in the layer with the other 24, so the
+   thresholds are scaled by 2^24.
+   Usage: mkziggurat > ziggurat.h
+*/
+
+#include <stdio.h>
+#include <math.h>
+
+#define LAYERS 256
+
+int main( int argc, char* argv[] ){
+
+	/* Start of the tail and area of each layer for 256 layers */
+	double r = 7.69711747013104972, v = 3.949659822581572e-3;
+	const double m = 16777216.0; /* 2^24 */
+	double x[LAYERS+1], q;
+	unsigned long k[LAYERS];
+	double w[LAYERS], f[LAYERS+1];
+	int i;
+
+	/* x[i] is the right edge of layer i, layer 0 being the base (with the
+	   tail) and layer 255 the top. */
+	x[0] = v / exp( -r );
+	x[1] = r;
+	for( i = 2; i < LAYERS; i++ )
+		x[i] = -log( v / x[i-1] + exp( -x[i-1] ) );
+	x[LAYERS] = 0;
+
+	/* The top layer should end at 0 */
+	q = -log( v / x[LAYERS-1] + exp( -x[LAYERS-1] ) );
+	if( fabs( q ) > 1e-9 ){
+		fprintf( stderr, "Layers do not close (%g)\n", q );
+		return 1;
+	}
+
+	/* Layer 0 is a rectangle of width x[0] whose part beyond r stands for
+	   the tail. Layer i > 0 spans heights f[i] to f[i+1]. */
+	k[0] = (unsigned long)( ( r / x[0] ) * m );
+	for( i = 1; i < LAYERS; i++ )
+		k[i] = (unsigned long)( ( x[i+1] / x[i] ) * m );
+	for( i = 0; i < LAYERS; i++ )
+		w[i] = x[i] / m;
+	for( i = 0; i <= LAYERS; i++ )
+		f[i] = exp( -x[i] );
+
+	printf( "/* Generated by mkziggurat.c, do not edit. */\n\n" );
+	printf( "#define ZIG_LAYERS %d\n", LAYERS );
+	printf( "#define ZIG_TAIL %.17g\n\n", r );
+
+	printf( "/* k[i]: the word is inside layer i's rectangle if below this */\n" );
+	printf( "static const unsigned long zig_k[ZIG_LAYERS] = {\n" );
+	for( i = 0; i < LAYERS; i++ )
+		printf( "%s%luUL%s", i % 6 ? " " : "\t", k[i],
+			i == LAYERS-1 ? "\n" : i % 6 == 5 ? ",\n" : "," );
+	printf( "};\n\n" );
+
+	printf( "/* w[i]: layer width / 2^24 */\n" );
+	printf( "static const double zig_w[ZIG_LAYERS] = {\n" );
+	for( i = 0; i < LAYERS; i++ )
+		printf( "%s%.17g%s", i % 3 ? " " : "\t", w[i],
+			i == LAYERS-1 ? "\n" : i % 3 == 2 ? ",\n" : "," );
+	printf( "};\n\n" );
+
+	printf( "/* f[i]: density at the right edge of layer i (f[ZIG_LAYERS] = 1) */\n" );
+	printf( "static const double zig_f[ZIG_LAYERS+1] = {\n" );
+	for( i = 0; i <= LAYERS; i++ )
+		printf( "%s%.17g%s", i % 3 ? " " : "\t", f[i],
+			i == LAYERS ? "\n" : i % 3 == 2 ? ",\n" : "," );
+	printf( "};\n" );
+
+	return 0;
+}
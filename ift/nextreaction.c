@@ -0,0 +1,247 @@
+/* Author: Yuriy Sverchkov
+   Filename: nextreaction.c
+   Purpose: Next-reaction engine for the IFT simulation (Gibson and Bruck,
+   2000).  Every IFT move and the disassembly keep a putative firing time in
+   an indexed heap, so the next event is the top of the heap.  Only the
+   event that fires draws a new exponential time: when an event's rate
+   changes because of another one (an IFT pushed onto the base, the length
+   reaching 0 or leaving it, an IFT blocked or unblocked under crowding), the
+   time it has left is rescaled by the ratio of the rates.  A rate that drops
+   to 0 keeps what was left of its time, in units of rate 1, and uses it up
+   when the rate is positive again.  That is one random number per event and
+   O(log n_ifts) work per changed rate, whatever the rates of the IFTs (they
+   may have speeds of their own, see InitialConditions).
+   The result is exact and has the same distribution as ift_step.
+   Included by ift.c for either movement rule (IFT_MOVE).
+*/
+
+#ifndef NEXTREACTION_C_INCLUDED
+#define NEXTREACTION_C_INCLUDED
+
+#include "heap.c"
+#if IFT_MOVE == MOVE_EXCLUSION
+#include "exclusion.c"
+#endif
+
+typedef struct{
+	unsigned n_ifts;
+	int * x;
+	unsigned head;
+	const double * speed;
+	double * rate;
+	double * left;
+	IndexHeap next;
+	short scheduled;
+} NextReactionState;
+/*NextReactionState: State of the next-reaction engine
+
+Events 0 to n_ifts-1 are the moves of the IFTs, event n_ifts is the
+disassembly.
+
+n_ifts - Number of IFT's.
+x - IFT positions (same notation as x0 in the InitialConditions struct).
+head - index of the IFT closest to the retrograde end (MOVE_EXCLUSION only).
+speed - the IFTs' speeds, from the initial conditions.
+rate - the rate of each event.
+left - for events of rate 0, the time they had left to wait at rate 1.
+next - the putative firing time of each event (HUGE_VAL for rate 0).
+scheduled - zero if the times have to be drawn at the next step.
+*/
+
+
+double nextreaction_rate( const NextReactionState * s,
+	const Parameters * const p, const unsigned i, const int length )
+/* Returns the rate of event i at the given length. */
+{
+	int x;
+
+	if( i == s->n_ifts ) return p->mu * can_disassemble( s->n_ifts, length );
+
+	x = s->x[i];
+#if IFT_MOVE == MOVE_EXCLUSION
+	/* Blocked by the IFT ahead; an IFT at the tip can always move */
+	if( x < length && s->x[ (i+1) % s->n_ifts ] == x + 1 ) return 0;
+#endif
+	return ( s->speed ? s->speed[i] : 1 )
+		* ( x >= 0 ? p->lambda_p : p->lambda_m );
+}
+
+void nextreaction_fire( NextReactionState * s, const Parameters * const p,
+	Rng * rng, const unsigned i, const double t, const int length )
+/* Draws a new firing time for event i, which has just fired at time t. */
+{
+	const double wait = ift_wait( rng );
+
+	s->rate[i] = nextreaction_rate( s, p, i, length );
+	if( s->rate[i] > 0 )
+		ihSet( &(s->next), i, t + wait / s->rate[i] );
+	else{
+		s->left[i] = wait;
+		ihSet( &(s->next), i, HUGE_VAL );
+	}
+}
+
+void nextreaction_update( NextReactionState * s, const Parameters * const p,
+	const unsigned i, const double t, const int length )
+/* Rescales the firing time of event i, which did not fire, to its rate
+   at time t. */
+{
+	const double rate = nextreaction_rate( s, p, i, length );
+	double left;
+
+	if( rate == s->rate[i] ) return;
+
+	left = s->rate[i] > 0 ? s->rate[i] * ( s->next.key[i] - t ) : s->left[i];
+	s->rate[i] = rate;
+	if( rate > 0 )
+		ihSet( &(s->next), i, t + left / rate );
+	else{
+		s->left[i] = left;
+		ihSet( &(s->next), i, HUGE_VAL );
+	}
+}
+
+void * nextreaction_create( const InitialConditions * const ic ){
+
+	NextReactionState * s =
+		(NextReactionState *) malloc( sizeof(NextReactionState) );
+
+	s->n_ifts = ic->n_ifts;
+	s->x = (int *) malloc( ( ic->n_ifts + (ic->n_ifts == 0) ) * sizeof(int) );
+	s->rate = (double *) malloc( ( ic->n_ifts + 1 ) * sizeof(double) );
+	s->left = (double *) malloc( ( ic->n_ifts + 1 ) * sizeof(double) );
+	s->next = ihCreate( ic->n_ifts + 1 );
+
+	return s;
+}
+
+void nextreaction_reset( void * state, const InitialConditions * const ic ){
+
+	NextReactionState * s = state;
+	unsigned i;
+
+	s->head = 0;
+	for( i = 0; i < s->n_ifts; i++ ){
+		s->x[i] = ic->x0[i];
+		if( s->x[i] < s->x[s->head] ) s->head = i;
+	}
+	s->speed = ic->speed;
+	s->scheduled = 0;
+}
+
+void nextreaction_destroy( void * state ){
+
+	NextReactionState * s = state;
+
+	ihDestroy( s->next );
+	free( s->x );
+	free( s->rate );
+	free( s->left );
+	free( s );
+}
+
+int nextreaction_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+/*int nextreaction_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+Represents a single step of the simulation, with the same dynamics as
+ift_step but events taken from the heap of firing times.  Under crowding,
+blocked moves are never picked (see unblocked.c).
+
+Return value:
+The change in length (+1, 0, or -1)
+*/
+{
+	NextReactionState * s = state;
+	const unsigned n = s->n_ifts;
+	unsigned i, j;
+	double now, wait;
+#if IFT_MOVE == MOVE_EXCLUSION
+	unsigned k;
+#endif
+	short length_change = 0;
+
+	if( !s->scheduled ){
+		for( i = 0; i <= n; i++ ){
+			wait = ift_wait( rng );
+			s->rate[i] = nextreaction_rate( s, p, i, *length );
+			s->left[i] = wait;
+			s->next.key[i] = s->rate[i] > 0 ? *t + wait / s->rate[i] : HUGE_VAL;
+		}
+		ihBuild( &(s->next) );
+		s->scheduled = 1;
+	}
+
+	/* Next event */
+	j = ihTop( &(s->next) );
+	now = s->next.key[j];
+
+	if( now > time_limit ){
+		*t = time_limit;
+		return 0;
+	}
+
+	if( j == n ){ /* Disassembly */
+
+		*length += ( length_change = -1 );
+
+#if IFT_MOVE == MOVE_EXCLUSION
+		/* Move the IFTs on the disassembled segment, then update the moved
+		   blocks and the IFT behind each of them. */
+		if( n > 0 ){
+			j = (s->head+n-1) % n;
+			for( k = push_down( s->x, n, *length, j ) + 1; k > 0; k-- ){
+				nextreaction_update( s, p, j, now, *length );
+				j = (j+n-1) % n;
+			}
+
+			j = (s->head+n-1) % n;
+			for( k = push_up( s->x, n, *length, s->head ) + 1; k > 0; k-- ){
+				nextreaction_update( s, p, j, now, *length );
+				j = (j+1) % n;
+			}
+		}
+#else
+		/* Move IFTs on Disassembled segment down; those pushed onto the
+		   base turn anterograde. */
+		for( i = 0; i < n; i++ )
+			if( s->x[i] == (*length)+1 )
+				--(s->x[i]);
+			else if( s->x[i] == -(*length)-1 && ++(s->x[i]) == 0 )
+				nextreaction_update( s, p, i, now, *length );
+#endif
+
+		nextreaction_fire( s, p, rng, n, now, *length );
+
+	}else{ /* Move IFT */
+
+		if( s->x[j] > *length - 1 ){ /* Then assembly occurs */
+
+			/* Increase length. */
+			*length += ( length_change = +1 );
+			/* Change direction on IFT */
+			s->x[j] = -(*length);
+			s->head = j;
+
+			if( !can_disassemble( n, *length - 1 ) )
+				nextreaction_update( s, p, n, now, *length );
+
+		}else ++(s->x[j]);
+
+		nextreaction_fire( s, p, rng, j, now, *length );
+#if IFT_MOVE == MOVE_EXCLUSION
+		/* The IFT behind j may have been waiting for it */
+		nextreaction_update( s, p, (j+n-1) % n, now, *length );
+#endif
+	}
+
+	*t = now;
+
+	return length_change;
+}
+
+const Engine nextreaction_engine = { "nextreaction",
+	nextreaction_create, nextreaction_reset, nextreaction_step,
+	nextreaction_destroy, 1 };
+
+#endif
@@ -0,0 +1,209 @@
+/* Author: Yuriy Sverchkov
+   Filename: occupancy.c
+   Purpose: Position-occupancy engine for the IFT simulation.
+   IFTs are interchangeable in this model, so instead of a position for each
+   IFT we keep the number of IFTs at each signed position -L..L.  A move
+   shifts one count to the next position, an assembly moves one count from
+   the tip to -L, and a disassembly only merges the two tip positions into
+   their neighbours, so no step looks at every IFT.
+   Included by ift.c.
+*/
+
+#ifndef OCCUPANCY_C_INCLUDED
+#define OCCUPANCY_C_INCLUDED
+
+#include "fenwick.c"
+
+typedef struct{
+	unsigned n_ifts;
+	int capacity;
+	long * count;
+	Fenwick tree;
+	unsigned n_ante;
+	unsigned n_retro;
+} OccupancyState;
+/*OccupancyState: State of the position-occupancy engine
+
+n_ifts - Number of IFT's.
+capacity - Largest length the arrays can currently hold.
+count - count[capacity+i] is the number of IFTs at position i, for
+	-capacity <= i <= capacity.
+tree - Fenwick tree over count, used to find the position of the k-th IFT.
+n_ante - Number of IFTs moving anterograde (at positions >= 0).
+n_retro - Number of IFTs moving retrograde (at positions < 0).
+*/
+
+
+void occupancy_grow( OccupancyState * s, const int length )
+/* Makes room for positions -length..length, keeping the current counts. */
+{
+	int i, old_capacity = s->capacity;
+	long * old_count = s->count;
+
+	if( length <= old_capacity ) return;
+
+	while( s->capacity < length ) s->capacity *= 2;
+
+	s->count = (long *) malloc( ( 2 * s->capacity + 1 ) * sizeof(long) );
+	for( i = 0; i < 2 * s->capacity + 1; i++ ) s->count[i] = 0;
+	for( i = -old_capacity; i <= old_capacity; i++ )
+		s->count[ s->capacity + i ] = old_count[ old_capacity + i ];
+	free( old_count );
+
+	fwDestroy( s->tree );
+	s->tree = fwCreate( 2 * s->capacity + 1 );
+	for( i = 0; i < 2 * s->capacity + 1; i++ )
+		if( s->count[i] != 0 ) fwAdd( &(s->tree), i, s->count[i] );
+}
+
+void occupancy_move( OccupancyState * s, const int from, const int to,
+	const long n )
+/* Moves n IFTs from position from to position to. */
+{
+	s->count[ s->capacity + from ] -= n;
+	s->count[ s->capacity + to ] += n;
+	fwAdd( &(s->tree), s->capacity + from, -n );
+	fwAdd( &(s->tree), s->capacity + to, n );
+}
+
+
+void * occupancy_create( const InitialConditions * const ic ){
+
+	OccupancyState * s = (OccupancyState *) malloc( sizeof(OccupancyState) );
+
+	s->n_ifts = ic->n_ifts;
+	s->capacity = 1;
+	s->count = (long *) malloc( 3 * sizeof(long) );
+	s->tree = fwCreate( 3 );
+	s->count[0] = s->count[1] = s->count[2] = 0;
+
+	return s;
+}
+
+void occupancy_reset( void * state, const InitialConditions * const ic ){
+
+	OccupancyState * s = state;
+	unsigned i;
+	int max = ic->length0;
+
+	for( i = 0; i < s->n_ifts; i++ ){
+		if( ic->x0[i] > max ) max = ic->x0[i];
+		if( -ic->x0[i] > max ) max = -ic->x0[i];
+	}
+	occupancy_grow( s, max );
+
+	for( i = 0; i < 2 * s->capacity + 1; i++ ) s->count[i] = 0;
+	fwDestroy( s->tree );
+	s->tree = fwCreate( 2 * s->capacity + 1 );
+
+	s->n_ante = s->n_retro = 0;
+	for( i = 0; i < s->n_ifts; i++ ){
+		++(s->count[ s->capacity + ic->x0[i] ]);
+		fwAdd( &(s->tree), s->capacity + ic->x0[i], 1 );
+		if( ic->x0[i] >= 0 ) ++(s->n_ante); else ++(s->n_retro);
+	}
+}
+
+void occupancy_destroy( void * state ){
+
+	OccupancyState * s = state;
+
+	fwDestroy( s->tree );
+	free( s->count );
+	free( s );
+}
+
+int occupancy_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+/*int occupancy_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+Represents a single step of the simulation, with the same dynamics as
+ift_step.  Costs O(log length) regardless of the number of IFTs.
+
+Return value:
+The change in length (+1, 0, or -1)
+*/
+{
+	OccupancyState * s = state;
+	int x;
+	long k;
+	double temp;
+	double tau = 0;
+	double ante_rate = p->lambda_p * s->n_ante;
+	double retro_rate = p->lambda_m * s->n_retro;
+	double rate_sum = ante_rate + retro_rate + p->mu * ( *length > 0 );
+	short length_change = 0;
+
+	if( rate_sum <= 0 ){ /* Impossible */
+		tau = time_limit - *t;
+		printf( "The sum of rates was nonpositive (%g).", rate_sum );
+	}else{
+		/* Get time until next event */
+		tau = ift_wait( rng ) / rate_sum;
+
+		/* Check if next event is within the time limit */
+		if( tau + *t > time_limit )
+			tau = time_limit - *t;
+		else{
+			/* Pick the event class, then the position of an IFT in the
+			   class.  Retrograde positions come first in the tree. */
+
+			temp = rate_sum * rng_uniform( rng );
+
+			if( temp < ante_rate ){ /* Anterograde move */
+
+				k = (long)( temp / p->lambda_p );
+				if( k >= s->n_ante ) k = s->n_ante - 1;
+				x = (int) fwFind( &(s->tree), s->n_retro + k ) - s->capacity;
+
+				if( x >= *length ){ /* Then assembly occurs */
+
+					*length += ( length_change = +1 );
+					occupancy_grow( s, *length );
+					occupancy_move( s, x, -(*length), 1 );
+					--(s->n_ante);
+					++(s->n_retro);
+
+				}else occupancy_move( s, x, x + 1, 1 );
+
+			}else if( ( temp -= ante_rate ) < retro_rate ){ /* Retrograde move */
+
+				k = (long)( temp / p->lambda_m );
+				if( k >= s->n_retro ) k = s->n_retro - 1;
+				x = (int) fwFind( &(s->tree), k ) - s->capacity;
+
+				occupancy_move( s, x, x + 1, 1 );
+				if( x + 1 == 0 ){ /* Reached the base */
+					--(s->n_retro);
+					++(s->n_ante);
+				}
+
+			}else{ /* Disassembly */
+
+				*length += ( length_change = -1 );
+
+				/* Move IFTs on Disassembled segment down. */
+				if( s->count[ s->capacity + *length + 1 ] != 0 )
+					occupancy_move( s, *length + 1, *length,
+						s->count[ s->capacity + *length + 1 ] );
+				if( ( k = s->count[ s->capacity - *length - 1 ] ) != 0 ){
+					occupancy_move( s, -(*length) - 1, -(*length), k );
+					if( *length == 0 ){ /* Pushed onto the base */
+						s->n_retro -= k;
+						s->n_ante += k;
+					}
+				}
+			}
+		}
+	}
+
+	/* Update time */
+	*t += tau;
+
+	return length_change;
+}
+
+const Engine occupancy_engine = { "occupancy",
+	occupancy_create, occupancy_reset, occupancy_step, occupancy_destroy, 0 };
+
+#endif
@@ -0,0 +1,220 @@
+/* Author: Yuriy Sverchkov
+   File: randist.c
+   Description: Random variates other than uniform ones (exponential, normal,
+   gamma, Erlang, beta, binomial and Poisson), built on the uniform variates of an Rng
+   context (see rng.c).
+*/
+
+#ifndef RANDIST_C_INCLUDED
+#define RANDIST_C_INCLUDED
+
+#include <math.h>
+#include "rng.c"
+#include "ziggurat.h"
+
+/* Exponential variates: ziggurat method (Marsaglia and Tsang, 2000).  A
+   32-bit word picks one of 256 layers of equal area covering the density
+   (low 8 bits) and a point across the layer (high 24 bits).  Inside the
+   part of the layer that lies under the density, the point is the variate;
+   that covers about 99% of the words and costs a multiplication.  The
+   tables are made by mkziggurat.c. */
+
+double rand_exp_slow( Rng * rng, uint32_t word )
+/* Finishes a draw whose word falls outside its layer's inner rectangle:
+   the tail, or a rejection test under the density, redrawing if rejected. */
+{
+	unsigned i;
+	double x;
+
+	for( ;; ){
+		i = word & 0xff;
+		x = (word >> 8) * zig_w[i];
+
+		if( (word >> 8) < zig_k[i] ) return x;
+
+		if( i == 0 ) /* Beyond ZIG_TAIL the density is exponential again */
+			return ZIG_TAIL - log( rng_uniform_open( rng ) );
+
+		if( zig_f[i] + rng_uniform( rng ) * ( zig_f[i+1] - zig_f[i] )
+			< exp( -x ) )
+			return x;
+
+		word = rng_uint32( rng );
+	}
+}
+
+void rand_exp_fill( Rng * rng, double out[], const int n )
+/* Fills out with n exponential variates with rate 1.  With SSE2 the inner
+   rectangle test and the scaling are done four words at a time, straight
+   from the generator's block. */
+{
+	int i = 0, j;
+	uint32_t word[4];
+#if defined(HAVE_SSE2)
+	__m128i v, m, accept;
+	const __m128i low = _mm_set1_epi32( 0xff );
+	unsigned layer[4];
+	int mask;
+#endif
+
+	while( i < n ){
+
+		if( rng->idx >= rng->size ) rng_refill( rng );
+
+#if defined(HAVE_SSE2)
+		/* Four 32-bit words per block (not dSFMT's two doubles) */
+		if( rng->kind != RNG_DSFMT && rng->idx % 4 == 0 && n - i >= 4 ){
+
+			v = rng->state[ rng->idx / 4 ].si;
+			rng->idx += 4;
+			_mm_storeu_si128( (__m128i *) word, v );
+			_mm_storeu_si128( (__m128i *) layer, _mm_and_si128( v, low ) );
+
+			m = _mm_srli_epi32( v, 8 );
+			accept = _mm_cmplt_epi32( m, _mm_set_epi32(
+				(int) zig_k[layer[3]], (int) zig_k[layer[2]],
+				(int) zig_k[layer[1]], (int) zig_k[layer[0]] ) );
+
+			_mm_storeu_pd( out + i, _mm_mul_pd( _mm_cvtepi32_pd( m ),
+				_mm_set_pd( zig_w[layer[1]], zig_w[layer[0]] ) ) );
+			_mm_storeu_pd( out + i + 2, _mm_mul_pd(
+				_mm_cvtepi32_pd( _mm_shuffle_epi32( m, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ),
+				_mm_set_pd( zig_w[layer[3]], zig_w[layer[2]] ) ) );
+
+			mask = _mm_movemask_ps( _mm_castsi128_ps( accept ) );
+			if( mask != 0xf )
+				for( j = 0; j < 4; j++ )
+					if( !( mask & (1 << j) ) )
+						out[i+j] = rand_exp_slow( rng, word[j] );
+			i += 4;
+			continue;
+		}
+#endif
+		word[0] = rng_uint32( rng );
+		j = word[0] & 0xff;
+		out[i++] = (word[0] >> 8) < zig_k[j] ?
+			(word[0] >> 8) * zig_w[j] : rand_exp_slow( rng, word[0] );
+	}
+}
+
+double rand_exp( Rng * rng )
+/* Returns an exponential variate with rate 1, from the context's batch. */
+{
+	if( rng->exp_idx >= RNG_EXP_BATCH ){
+		rand_exp_fill( rng, rng->exponential, RNG_EXP_BATCH );
+		rng->exp_idx = 0;
+	}
+	return rng->exponential[ rng->exp_idx++ ];
+}
+
+double rand_normal( Rng * rng )
+/* Returns a standard normal variate (polar method). */
+{
+	double u, v, s;
+
+	do{
+		u = 2 * rng_uniform_open( rng ) - 1;
+		v = 2 * rng_uniform_open( rng ) - 1;
+		s = u * u + v * v;
+	}while( s >= 1 || s == 0 );
+
+	return u * sqrt( -2 * log( s ) / s );
+}
+
+double rand_gamma( Rng * rng, const double a )
+/* Returns a gamma variate with shape a >= 1 and scale 1
+   (Marsaglia and Tsang, 2000). */
+{
+	double d = a - 1.0 / 3, c = 1 / sqrt( 9 * d ), x, v, u;
+
+	for( ;; ){
+		do{
+			x = rand_normal( rng );
+			v = 1 + c * x;
+		}while( v <= 0 );
+
+		v = v * v * v;
+		u = rng_uniform_open( rng );
+
+		if( u < 1 - 0.0331 * x * x * x * x
+			|| log( u ) < 0.5 * x * x + d * ( 1 - v + log( v ) ) )
+			return d * v;
+	}
+}
+
+double rand_erlang( Rng * rng, const unsigned n, const double rate )
+/* Returns the time of the n-th event of a Poisson process with the given
+   rate (0 if n is 0). */
+{
+	unsigned i;
+	double prod = 1;
+
+	if( n > 16 ) return rand_gamma( rng, n ) / rate;
+
+	for( i = 0; i < n; i++ ) prod *= rng_uniform_open( rng );
+	return -log( prod ) / rate;
+}
+
+unsigned rand_binomial( Rng * rng, unsigned n, double p )
+/* Returns a binomial variate with n trials of success probability p.
+   Large n is split with beta variates (Knuth, TAOCP 3.4.1) until few enough
+   trials remain to simulate them one by one. */
+{
+	unsigned a, k = 0;
+	double x, y;
+
+	while( n > 32 && p > 0 && p < 1 ){
+
+		/* x is the a-th smallest of n uniforms */
+		a = 1 + n / 2;
+		x = rand_gamma( rng, a );
+		y = rand_gamma( rng, n + 1 - a );
+		x = x / ( x + y );
+
+		if( x >= p ){
+			n = a - 1;
+			p = p / x;
+		}else{
+			k += a;
+			n = n - a;
+			p = ( p - x ) / ( 1 - x );
+		}
+	}
+
+	if( p <= 0 ) return k;
+	if( p >= 1 ) return k + n;
+
+	for( ; n > 0; n-- )
+		k += rng_uniform( rng ) < p;
+
+	return k;
+}
+
+unsigned rand_poisson( Rng * rng, double mean )
+/* Returns a Poisson variate of the given mean.  Large means are reduced with
+   gamma variates, the times of the m-th events (Knuth, TAOCP 3.4.1), until
+   the product of uniforms is short enough. */
+{
+	unsigned m, k = 0;
+	double x, prod;
+
+	while( mean > 16 ){
+
+		m = (unsigned) ( mean * 7 / 8 );
+		x = rand_gamma( rng, m );
+
+		/* The first m-1 events fall uniformly before x */
+		if( x >= mean ) return k + rand_binomial( rng, m - 1, mean / x );
+
+		k += m;
+		mean -= x;
+	}
+
+	for( x = exp( -mean ), prod = rng_uniform_open( rng ); prod >= x;
+		prod *= rng_uniform_open( rng ) )
+		++k;
+
+	return k;
+}
+
+#endif
@@ -0,0 +1,569 @@
+/* Author: Yuriy Sverchkov
+   File: rng.c
+   Description: Random number generator contexts.
+   The generator is the SIMD-oriented Fast Mersenne Twister (SFMT 1.3, by
+   Mutsuo Saito and Makoto Matsumoto, see ../SFMT-src-1.3 for its license),
+   with the state kept in an Rng struct instead of in file globals, so that
+   each thread can own a generator and the simulation touches no shared
+   state.  The output for a given seed is the same as SFMT's.
+   Every period of SFMT (2^607-1 to 2^216091-1) is compiled in, and each
+   context runs the one it was seeded with (see sfmt-period.c).
+   The generator makes its numbers a block at a time; each block is
+   also converted to doubles in one vectorized pass, so drawing a uniform
+   variate is a load from a buffer.  A context's buffers are sized for the
+   generator it is seeded with, so short periods keep the context small.
+   A context can instead run the counter-based Philox4x32-10 generator
+   (Salmon, Moraes, Dror and Shaw, 2011), whose output is a function of a
+   key and a counter.  Keying it with a user seed and a run number gives
+   every run its own stream, the same whichever thread or process runs it.
+   Or it can run dSFMT (see dsfmt.c), which makes doubles directly, with 52
+   random bits instead of 32.
+*/
+
+#ifndef RNG_C_INCLUDED
+#define RNG_C_INCLUDED
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+/* Wider versions of the recursion, compiled for AVX2 and AVX-512 whatever
+   the target and used only if the processor has them. */
+#define RNG_DISPATCH
+#include <immintrin.h>
+#endif
+#endif
+
+typedef union{
+#if defined(HAVE_SSE2)
+	__m128i si;
+	__m128d sd;
+#endif
+	uint32_t u[4];
+	uint64_t u64[2];
+	double d[2];
+} RngBlock;
+/*RngBlock: 128 bits of generator state */
+
+static uint32_t rng_word( const RngBlock * w, const int i ){
+	return w[i/4].u[i%4];
+}
+
+static void rng_set_word( RngBlock * w, const int i, const uint32_t value ){
+	w[i/4].u[i%4] = value;
+}
+
+#include "dsfmt.c"
+
+/* Each period of SFMT has its own shifts and masks, and its own copy of the
+   recursion made from sfmt-period.c with them. */
+
+typedef struct{
+	int mexp;
+	int n;
+	uint32_t parity[4];
+	const char * idstr;
+	void (*regenerate)( RngBlock * w );
+	void (*regenerate_avx2)( RngBlock * w );
+	void (*regenerate_avx512)( RngBlock * w );
+} RngPeriod;
+/*RngPeriod: One period of SFMT
+
+mexp - the Mersenne exponent: the period is 2^mexp-1.
+n - the number of blocks of state (and of output made at a time).
+parity - the period certification vector.
+idstr - SFMT's name for the parameter set.
+regenerate - replaces the n blocks of state with the next n (SSE2 or plain C).
+regenerate_avx2, regenerate_avx512 - the same, with 2 or 4 blocks per vector;
+	NULL if not compiled in or if the period is too short for them.
+*/
+
+#define RNG_SFMT 0
+#define RNG_PHILOX 1
+#define RNG_DSFMT 2
+
+/* Blocks of Philox output made at a time */
+#define RNG_PHILOX_N 64
+#define RNG_EXP_BATCH 256
+
+typedef struct{
+	RngBlock * state;
+	double * uniform;
+	int capacity;
+	int idx;
+	int size;
+	double half_step;
+	double exponential[RNG_EXP_BATCH];
+	int exp_idx;
+	short kind;
+	const RngPeriod * period;
+	uint32_t key[2];
+	uint32_t counter[4];
+} Rng;
+/*Rng: A generator context
+
+state - the generator state, which is also the current block of output.
+uniform - the outputs in the block as doubles on [0,1): word / 2^32 for SFMT
+	and Philox, double - 1 for dSFMT.
+capacity - the number of blocks state holds (uniform holds 4 doubles per
+	block): grown when the context is seeded for a larger state.
+idx - index of the next output of the block to hand out (as an integer or
+	as a uniform); the next block is made when it reaches size.
+size - the number of outputs in a block: 4 32-bit words per block of state
+	for SFMT (period->n blocks) and Philox (RNG_PHILOX_N), 2 DSFMT_N doubles
+	for dSFMT.
+half_step - half the spacing of the uniforms.
+exponential, exp_idx - unit exponential variates made in batches by rand_exp
+	(see randist.c), and the index of the next one.
+kind - the generator: RNG_SFMT, RNG_PHILOX or RNG_DSFMT.
+period - the period of SFMT.
+key, counter - Philox key and the counter of the next Philox output.
+*/
+
+
+Rng * rng_create( void )
+/* Allocates a context, to be seeded with one of the rng_init functions.
+   Free with rng_destroy. */
+{
+	Rng * rng = (Rng *) malloc( sizeof(Rng) );
+
+	rng->state = NULL;
+	rng->uniform = NULL;
+	rng->capacity = 0;
+	return rng;
+}
+
+void rng_destroy( Rng * rng ){
+
+	free( rng->state );
+	free( rng->uniform );
+	free( rng );
+}
+
+static void rng_reserve( Rng * rng, const int blocks )
+/* Makes room for a state of the given number of blocks. */
+{
+	if( blocks <= rng->capacity ) return;
+
+	/* malloc aligns on 16 bytes, as the blocks need */
+	free( rng->state );
+	free( rng->uniform );
+	rng->state = (RngBlock *) malloc( blocks * sizeof(RngBlock) );
+	rng->uniform = (double *) malloc( 4 * blocks * sizeof(double) );
+	rng->capacity = blocks;
+}
+
+
+#define RNG_PASTE2( a, b ) a ## b
+#define RNG_PASTE( a, b ) RNG_PASTE2( a, b )
+
+#if !defined(HAVE_SSE2)
+
+static void rng_shift128( uint32_t out[4], const uint32_t in[4],
+	const int shift )
+/* Shifts a 128-bit little endian value by shift bytes: left if shift > 0,
+   right if shift < 0. */
+{
+	uint64_t th, tl, oh, ol;
+
+	th = ((uint64_t)in[3] << 32) | ((uint64_t)in[2]);
+	tl = ((uint64_t)in[1] << 32) | ((uint64_t)in[0]);
+
+	if( shift > 0 ){
+		oh = th << (shift * 8);
+		ol = tl << (shift * 8);
+		oh |= tl >> (64 - shift * 8);
+	}else{
+		oh = th >> (-shift * 8);
+		ol = tl >> (-shift * 8);
+		ol |= th << (64 + shift * 8);
+	}
+	out[1] = (uint32_t)(ol >> 32);
+	out[0] = (uint32_t)ol;
+	out[3] = (uint32_t)(oh >> 32);
+	out[2] = (uint32_t)oh;
+}
+
+#endif
+
+#define SFMT_MEXP 607
+#include "../SFMT-src-1.3/SFMT-params607.h"
+#include "sfmt-period.c"
+#define SFMT_MEXP 1279
+#include "../SFMT-src-1.3/SFMT-params1279.h"
+#include "sfmt-period.c"
+#define SFMT_MEXP 2281
+#include "../SFMT-src-1.3/SFMT-params2281.h"
+#include "sfmt-period.c"
+#define SFMT_MEXP 4253
+#include "../SFMT-src-1.3/SFMT-params4253.h"
+#include "sfmt-period.c"
+#define SFMT_MEXP 11213
+#include "../SFMT-src-1.3/SFMT-params11213.h"
+#include "sfmt-period.c"
+#define SFMT_MEXP 19937
+#include "../SFMT-src-1.3/SFMT-params19937.h"
+#include "sfmt-period.c"
+#define SFMT_MEXP 44497
+#include "../SFMT-src-1.3/SFMT-params44497.h"
+#include "sfmt-period.c"
+#define SFMT_MEXP 86243
+#include "../SFMT-src-1.3/SFMT-params86243.h"
+#include "sfmt-period.c"
+#define SFMT_MEXP 132049
+#include "../SFMT-src-1.3/SFMT-params132049.h"
+#include "sfmt-period.c"
+#define SFMT_MEXP 216091
+#include "../SFMT-src-1.3/SFMT-params216091.h"
+#include "sfmt-period.c"
+
+const RngPeriod * const rng_periods[] = { &sfmt_period_607, &sfmt_period_1279,
+	&sfmt_period_2281, &sfmt_period_4253, &sfmt_period_11213,
+	&sfmt_period_19937, &sfmt_period_44497, &sfmt_period_86243,
+	&sfmt_period_132049, &sfmt_period_216091, NULL };
+
+/* The period of contexts seeded without one (MEXP as in SFMT's makefiles) */
+#if !defined(MEXP)
+#define MEXP 19937
+#endif
+#define RNG_DEFAULT_PERIOD ( &RNG_PASTE( sfmt_period_, MEXP ) )
+
+const RngPeriod * rng_find_period( const int mexp )
+/* Returns the period with Mersenne exponent mexp, or NULL if there is none. */
+{
+	int i;
+
+	for( i = 0; rng_periods[i]; i++ )
+		if( rng_periods[i]->mexp == mexp ) return rng_periods[i];
+	return NULL;
+}
+
+int rng_width = 0;
+/* Blocks per vector of the recursion in use: 1 (SSE2), 2 (AVX2) or 4
+   (AVX-512), or 0 for SSE2 until rng_dispatch is called.  It can be set to
+   force a narrower one.  All give the same numbers.  Generators only read
+   it, so it must be set before any thread makes numbers. */
+
+void rng_dispatch( void )
+/* Sets rng_width, if not set yet, to the widest the processor supports.
+   Call it once at startup, before starting threads. */
+{
+#if defined(RNG_DISPATCH)
+	if( rng_width == 0 )
+		rng_width = __builtin_cpu_supports( "avx512bw" ) ? 4
+			: __builtin_cpu_supports( "avx2" ) ? 2 : 1;
+#endif
+}
+
+void rng_regenerate( Rng * rng )
+/* Replaces the whole state with the next block of SFMT output, with the
+   vector instructions rng_width says. */
+{
+	const RngPeriod * const period = rng->period;
+
+#if defined(RNG_DISPATCH)
+	if( rng_width == 4 && period->regenerate_avx512 )
+		period->regenerate_avx512( rng->state );
+	else if( rng_width >= 2 && period->regenerate_avx2 )
+		period->regenerate_avx2( rng->state );
+	else
+#endif
+	period->regenerate( rng->state );
+}
+
+#define PHILOX_M0 0xD2511F53UL
+#define PHILOX_M1 0xCD9E8D57UL
+#define PHILOX_W0 0x9E3779B9UL
+#define PHILOX_W1 0xBB67AE85UL
+
+void rng_philox( uint32_t out[4], const uint32_t counter[4],
+	const uint32_t key[2] )
+/* Philox4x32-10: encrypts the counter with the key. */
+{
+	uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	uint64_t p0, p1;
+	int round;
+
+	for( round = 0; round < 10; round++ ){
+		p0 = (uint64_t) PHILOX_M0 * c0;
+		p1 = (uint64_t) PHILOX_M1 * c2;
+		c0 = (uint32_t)( p1 >> 32 ) ^ c1 ^ k0;
+		c2 = (uint32_t)( p0 >> 32 ) ^ c3 ^ k1;
+		c1 = (uint32_t) p1;
+		c3 = (uint32_t) p0;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
+}
+
+void rng_philox_block( Rng * rng )
+/* Replaces the state with the Philox outputs for the next RNG_PHILOX_N
+   counters. */
+{
+	int i;
+
+	for( i = 0; i < RNG_PHILOX_N; i++ ){
+		rng_philox( rng->state[i].u, rng->counter, rng->key );
+		if( ++(rng->counter[0]) == 0 ) ++(rng->counter[1]);
+	}
+}
+
+void rng_refill( Rng * rng )
+/* Makes the next block of output and its uniform variates. */
+{
+	int i;
+	const double scale = 1.0/4294967296.0;
+#if defined(HAVE_SSE2)
+	/* SSE2 only converts signed integers: flip the sign bit, convert, then
+	   add 2^31 back. */
+	const __m128i flip = _mm_set1_epi32( (int) 0x80000000UL );
+	const __m128d offset = _mm_set1_pd( 2147483648.0 );
+	const __m128d vscale = _mm_set1_pd( scale );
+	__m128i v;
+#endif
+
+	if( rng->kind == RNG_DSFMT ){
+
+		/* The outputs are doubles on [1,2) already */
+		dsfmt_regenerate( rng->state );
+#if defined(HAVE_SSE2)
+		for( i = 0; i < DSFMT_N; i++ )
+			_mm_storeu_pd( rng->uniform + 2*i,
+				_mm_sub_pd( rng->state[i].sd, _mm_set1_pd( 1.0 ) ) );
+#else
+		for( i = 0; i < 2*DSFMT_N; i++ )
+			rng->uniform[i] = rng->state[i/2].d[i%2] - 1.0;
+#endif
+		rng->idx = 0;
+		return;
+	}
+
+	if( rng->kind == RNG_PHILOX )
+		rng_philox_block( rng );
+	else
+		rng_regenerate( rng );
+
+#if defined(HAVE_SSE2)
+	for( i = 0; i < rng->size / 4; i++ ){
+		v = _mm_xor_si128( rng->state[i].si, flip );
+		_mm_storeu_pd( rng->uniform + 4*i, _mm_mul_pd( vscale,
+			_mm_add_pd( _mm_cvtepi32_pd( v ), offset ) ) );
+		_mm_storeu_pd( rng->uniform + 4*i + 2, _mm_mul_pd( vscale,
+			_mm_add_pd( _mm_cvtepi32_pd( _mm_shuffle_epi32( v,
+				_MM_SHUFFLE( 1, 0, 3, 2 ) ) ), offset ) ) );
+	}
+#else
+	for( i = 0; i < rng->size; i++ )
+		rng->uniform[i] = rng->state[i/4].u[i%4] * scale;
+#endif
+
+	rng->idx = 0;
+}
+
+static void rng_start( Rng * rng, const short kind )
+/* Sets up the context for a freshly seeded generator of the given kind. */
+{
+	rng->kind = kind;
+	rng->size = kind == RNG_DSFMT ? 2 * DSFMT_N
+		: kind == RNG_PHILOX ? 4 * RNG_PHILOX_N : 4 * rng->period->n;
+	rng->half_step = kind == RNG_DSFMT ? 0.5/4503599627370496.0
+		: 0.5/4294967296.0;
+	rng->idx = rng->size;
+	rng->exp_idx = RNG_EXP_BATCH;
+}
+
+static void rng_certify( Rng * rng )
+/* Makes sure the period is 2^mexp-1 by fixing one bit if necessary. */
+{
+	const uint32_t * const parity = rng->period->parity;
+	uint32_t inner = 0, work;
+	int i, j;
+
+	for( i = 0; i < 4; i++ )
+		inner ^= rng->state[0].u[i] & parity[i];
+	for( i = 16; i > 0; i >>= 1 )
+		inner ^= inner >> i;
+	if( inner & 1 ) return;
+
+	for( i = 0; i < 4; i++ )
+		for( j = 0, work = 1; j < 32; j++, work <<= 1 )
+			if( work & parity[i] ){
+				rng->state[0].u[i] ^= work;
+				return;
+			}
+}
+
+static void rng_seed_linear( RngBlock * w, const int size, const uint32_t seed )
+/* Fills the first size words of w from a 32-bit integer (the seeding of
+   init_gen_rand in SFMT and dSFMT). */
+{
+	int i;
+	uint32_t prev = seed;
+
+	rng_set_word( w, 0, seed );
+	for( i = 1; i < size; i++ ){
+		prev = 1812433253UL * ( prev ^ ( prev >> 30 ) ) + i;
+		rng_set_word( w, i, prev );
+	}
+}
+
+static uint32_t rng_mix1( const uint32_t x ){
+	return (x ^ (x >> 27)) * (uint32_t)1664525UL;
+}
+
+static uint32_t rng_mix2( const uint32_t x ){
+	return (x ^ (x >> 27)) * (uint32_t)1566083941UL;
+}
+
+static void rng_seed_array( RngBlock * w, const int size,
+	const uint32_t key[], const int key_length )
+/* Fills the first size words of w from an array of integers (the seeding of
+   init_by_array in SFMT and dSFMT). */
+{
+	int i, j, count;
+	uint32_t r;
+	const int lag = size >= 623 ? 11 : size >= 68 ? 7 : size >= 39 ? 5 : 3;
+	const int mid = ( size - lag ) / 2;
+
+	memset( w, 0x8b, size * sizeof(uint32_t) );
+	count = key_length + 1 > size ? key_length + 1 : size;
+
+	r = rng_mix1( rng_word( w, 0 ) ^ rng_word( w, mid )
+		^ rng_word( w, size - 1 ) );
+	rng_set_word( w, mid, rng_word( w, mid ) + r );
+	r += key_length;
+	rng_set_word( w, mid + lag, rng_word( w, mid + lag ) + r );
+	rng_set_word( w, 0, r );
+
+	count--;
+	for( i = 1, j = 0; j < count; j++ ){
+		r = rng_mix1( rng_word( w, i ) ^ rng_word( w, (i + mid) % size )
+			^ rng_word( w, (i + size - 1) % size ) );
+		rng_set_word( w, (i + mid) % size,
+			rng_word( w, (i + mid) % size ) + r );
+		r += ( j < key_length ? key[j] : 0 ) + i;
+		rng_set_word( w, (i + mid + lag) % size,
+			rng_word( w, (i + mid + lag) % size ) + r );
+		rng_set_word( w, i, r );
+		i = (i + 1) % size;
+	}
+	for( j = 0; j < size; j++ ){
+		r = rng_mix2( rng_word( w, i ) + rng_word( w, (i + mid) % size )
+			+ rng_word( w, (i + size - 1) % size ) );
+		rng_set_word( w, (i + mid) % size,
+			rng_word( w, (i + mid) % size ) ^ r );
+		r -= i;
+		rng_set_word( w, (i + mid + lag) % size,
+			rng_word( w, (i + mid + lag) % size ) ^ r );
+		rng_set_word( w, i, r );
+		i = (i + 1) % size;
+	}
+}
+
+void rng_init_period( Rng * rng, const RngPeriod * const period,
+	const uint32_t seed )
+/* Seeds SFMT of the given period with a 32-bit integer (same as SFMT's
+   init_gen_rand built for that period). */
+{
+	rng_reserve( rng, period->n );
+	rng->period = period;
+	rng_seed_linear( rng->state, 4 * period->n, seed );
+	rng_certify( rng );
+	rng_start( rng, RNG_SFMT );
+}
+
+void rng_init_period_by_array( Rng * rng, const RngPeriod * const period,
+	const uint32_t key[], const int key_length )
+/* Seeds SFMT of the given period with an array of integers (same as SFMT's
+   init_by_array).  Keys that differ in any word give unrelated streams. */
+{
+	rng_reserve( rng, period->n );
+	rng->period = period;
+	rng_seed_array( rng->state, 4 * period->n, key, key_length );
+	rng_certify( rng );
+	rng_start( rng, RNG_SFMT );
+}
+
+void rng_init( Rng * rng, const uint32_t seed )
+/* Seeds SFMT of the default period with a 32-bit integer. */
+{
+	rng_init_period( rng, RNG_DEFAULT_PERIOD, seed );
+}
+
+void rng_init_by_array( Rng * rng, const uint32_t key[], const int key_length )
+/* Seeds SFMT of the default period with an array of integers. */
+{
+	rng_init_period_by_array( rng, RNG_DEFAULT_PERIOD, key, key_length );
+}
+
+void rng_init_double( Rng * rng, const uint32_t seed )
+/* Seeds dSFMT with a 32-bit integer (same as dSFMT's init_gen_rand). */
+{
+	rng_reserve( rng, DSFMT_N + 1 );
+	rng_seed_linear( rng->state, 4 * ( DSFMT_N + 1 ), seed );
+	dsfmt_prepare( rng->state );
+	rng_start( rng, RNG_DSFMT );
+}
+
+void rng_init_double_by_array( Rng * rng, const uint32_t key[],
+	const int key_length )
+/* Seeds dSFMT with an array of integers (same as dSFMT's init_by_array). */
+{
+	rng_reserve( rng, DSFMT_N + 1 );
+	rng_seed_array( rng->state, 4 * ( DSFMT_N + 1 ), key, key_length );
+	dsfmt_prepare( rng->state );
+	rng_start( rng, RNG_DSFMT );
+}
+
+void rng_init_counter( Rng * rng, const uint32_t key[2],
+	const uint32_t stream[2] )
+/* Switches the generator to Philox with the given key, at the start of the
+   given stream: the counters (i, stream[0], stream[1]) for i = 0, 1, ...
+   (2^64 outputs of 128 bits).  Contexts with the same key and stream give
+   the same sequence. */
+{
+	rng_reserve( rng, RNG_PHILOX_N );
+	rng->key[0] = key[0];
+	rng->key[1] = key[1];
+	rng->counter[0] = rng->counter[1] = 0;
+	rng->counter[2] = stream[0];
+	rng->counter[3] = stream[1];
+	rng_start( rng, RNG_PHILOX );
+}
+
+uint32_t rng_uint32( Rng * rng )
+/* Returns a uniform 32-bit integer (the low bits of the mantissa for
+   dSFMT, as in dSFMT's genrand_uint32). */
+{
+	if( rng->idx >= rng->size ) rng_refill( rng );
+	if( rng->kind == RNG_DSFMT ){
+		++(rng->idx);
+		return (uint32_t) rng->state[ (rng->idx-1)/2 ].u64[ (rng->idx-1)%2 ];
+	}
+	return rng_word( rng->state, rng->idx++ );
+}
+
+double rng_uniform( Rng * rng )
+/* Returns a uniform number on [0,1) (like genrand_real2). */
+{
+	if( rng->idx >= rng->size ) rng_refill( rng );
+	return rng->uniform[ rng->idx++ ];
+}
+
+double rng_uniform_open( Rng * rng )
+/* Returns a uniform number on (0,1) (like genrand_real3). */
+{
+	if( rng->idx >= rng->size ) rng_refill( rng );
+	return rng->uniform[ rng->idx++ ] + rng->half_step;
+}
+
+#endif
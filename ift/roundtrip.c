@@ -0,0 +1,212 @@
+/* Author: Yuriy Sverchkov
+   Filename: roundtrip.c
+   Purpose: Round-trip engine for the IFT simulation.
+   Without crowding an IFT's hops form a Poisson process, so instead of
+   simulating every hop we sample directly the time at which each IFT next
+   turns around: at the tip (an assembly, after an Erlang number of
+   anterograde hops) or at the base (after an Erlang number of retrograde
+   hops).  Only assemblies, disassemblies and arrivals at the base are
+   events, so a round trip costs two events instead of about 2L.
+
+   The schedule of an IFT depends on the length, which other events change:
+   - After an assembly the tip is one hop further away, so every other
+     anterograde IFT needs one more exponential hop.
+   - A disassembly moves the tip one hop closer, so every anterograde IFT
+     turns one hop earlier.  Given that the n-th hop since the last known
+     position (at time t) comes at time T, the hops before it are n-1
+     uniform times on (t,T), and the (n-1)-th is the largest of them: one
+     uniform draw moves the turn there.  Only an IFT whose earlier turn has
+     already passed is at the old tip; it is pushed back onto the new one
+     and has a single hop left.  A retrograde IFT last known at the old end
+     has its current position drawn from its schedule: the number of hops
+     made by time s is binomial with n-1 trials and success probability
+     (s-t)/(T-t).  If it has not moved it is pushed forward and rescheduled.
+   The result is exact and has the same distribution as ift_step.
+   Included by ift.c.
+*/
+
+#ifndef ROUNDTRIP_C_INCLUDED
+#define ROUNDTRIP_C_INCLUDED
+
+#include "randist.c"
+
+typedef struct{
+	unsigned n_ifts;
+	int * x;
+	double * t_ref;
+	double * t_next;
+	double t_dis;
+	short scheduled;
+} RoundTripState;
+/*RoundTripState: State of the round-trip engine
+
+n_ifts - Number of IFT's.
+x - IFT positions at the times in t_ref (same notation as x0 in the
+	InitialConditions struct).
+t_ref - the last time at which the position of each IFT was known.
+t_next - the time at which each IFT next turns around: reaches the tip if
+	x >= 0 or the base if x < 0.
+t_dis - the time of the next disassembly.
+scheduled - zero if the times have to be drawn at the next step.
+*/
+
+
+void * roundtrip_create( const InitialConditions * const ic ){
+
+	RoundTripState * s = (RoundTripState *) malloc( sizeof(RoundTripState) );
+	unsigned size = ic->n_ifts + (ic->n_ifts == 0);
+
+	s->n_ifts = ic->n_ifts;
+	s->x = (int *) malloc( size * sizeof(int) );
+	s->t_ref = (double *) malloc( size * sizeof(double) );
+	s->t_next = (double *) malloc( size * sizeof(double) );
+
+	return s;
+}
+
+void roundtrip_reset( void * state, const InitialConditions * const ic ){
+
+	RoundTripState * s = state;
+	unsigned i;
+
+	for( i = 0; i < s->n_ifts; i++ ) s->x[i] = ic->x0[i];
+	s->scheduled = 0;
+}
+
+void roundtrip_destroy( void * state ){
+
+	RoundTripState * s = state;
+
+	free( s->x );
+	free( s->t_ref );
+	free( s->t_next );
+	free( s );
+}
+
+void roundtrip_schedule( RoundTripState * s, const Parameters * const p,
+	Rng * rng, const unsigned i, const double t, const int length )
+/* Draws the time at which IFT i, known to be at x[i] at time t, turns around. */
+{
+	s->t_ref[i] = t;
+
+	if( s->x[i] >= 0 )
+		s->t_next[i] = t + rand_erlang( rng, length - s->x[i] + 1,
+			p->lambda_p );
+	else
+		s->t_next[i] = t + rand_erlang( rng, -(s->x[i]), p->lambda_m );
+}
+
+int roundtrip_bridge( const RoundTripState * s, Rng * rng,
+	const unsigned i, const unsigned n, const double t )
+/* Returns the position at time t of IFT i, whose n-th hop since t_ref[i]
+   comes at t_next[i]. */
+{
+	if( n <= 1 ) return s->x[i];
+
+	return s->x[i] + (int) rand_binomial( rng, n - 1,
+		( t - s->t_ref[i] ) / ( s->t_next[i] - s->t_ref[i] ) );
+}
+
+double roundtrip_earlier( const RoundTripState * s, Rng * rng,
+	const unsigned i, const unsigned n )
+/* Returns the time of the (n-1)-th hop since t_ref[i] of IFT i, whose n-th
+   hop comes at t_next[i] (n > 1). */
+{
+	return s->t_ref[i] + ( s->t_next[i] - s->t_ref[i] )
+		* pow( rng_uniform( rng ), 1.0 / ( n - 1 ) );
+}
+
+int roundtrip_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+/*int roundtrip_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+Advances the simulation to the next assembly, disassembly or arrival of an
+IFT at the base.
+
+Return value:
+The change in length (+1, 0, or -1)
+*/
+{
+	RoundTripState * s = state;
+	unsigned i, j, n;
+	double now;
+	short length_change = 0;
+
+	if( !s->scheduled ){
+		for( i = 0; i < s->n_ifts; i++ )
+			roundtrip_schedule( s, p, rng, i, *t, *length );
+		s->t_dis = ( *length > 0 && p->mu > 0 ) ?
+			*t + ift_wait( rng ) / p->mu : HUGE_VAL;
+		s->scheduled = 1;
+	}
+
+	/* Find the next event */
+	now = s->t_dis;
+	j = s->n_ifts;
+	for( i = 0; i < s->n_ifts; i++ )
+		if( s->t_next[i] < now ) now = s->t_next[ j = i ];
+
+	if( now > time_limit ){
+		*t = time_limit;
+		return 0;
+	}
+
+	if( j == s->n_ifts ){ /* Disassembly */
+
+		*length += ( length_change = -1 );
+
+		for( i = 0; i < s->n_ifts; i++ )
+
+			if( s->x[i] >= 0 ){
+
+				/* The turn one hop earlier, unless that has passed */
+				n = *length - s->x[i] + 2;
+				if( n > 1 && ( s->t_next[i] = roundtrip_earlier( s, rng, i, n ) )
+					> now ) continue;
+
+				/* At the old tip: move it down onto the new one */
+				s->x[i] = *length;
+				roundtrip_schedule( s, p, rng, i, now, *length );
+
+			}else if( s->x[i] == -(*length)-1 ){
+
+				s->x[i] = roundtrip_bridge( s, rng, i, (*length)+1, now );
+				if( s->x[i] == -(*length)-1 ){
+					++(s->x[i]);
+					roundtrip_schedule( s, p, rng, i, now, *length );
+				}else
+					s->t_ref[i] = now;
+			}
+
+		s->t_dis = ( *length > 0 ) ? now + ift_wait( rng ) / p->mu : HUGE_VAL;
+
+	}else if( s->x[j] >= 0 ){ /* Assembly */
+
+		*length += ( length_change = +1 );
+
+		/* The tip is one hop further for the other anterograde IFTs */
+		for( i = 0; i < s->n_ifts; i++ )
+			if( s->x[i] >= 0 && i != j )
+				s->t_next[i] += ift_wait( rng ) / p->lambda_p;
+
+		s->x[j] = -(*length);
+		roundtrip_schedule( s, p, rng, j, now, *length );
+
+		if( *length == 1 && p->mu > 0 )
+			s->t_dis = now + ift_wait( rng ) / p->mu;
+
+	}else{ /* Arrival at the base */
+
+		s->x[j] = 0;
+		roundtrip_schedule( s, p, rng, j, now, *length );
+	}
+
+	*t = now;
+
+	return length_change;
+}
+
+const Engine roundtrip_engine = { "roundtrip",
+	roundtrip_create, roundtrip_reset, roundtrip_step, roundtrip_destroy, 0 };
+
+#endif
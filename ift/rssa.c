@@ -0,0 +1,202 @@
+/* Author: Yuriy Sverchkov
+   Filename: rssa.c
+   Purpose: Rejection-based engine for the IFT simulation with crowding
+   (RSSA, Thanh et al., 2014).
+   The rate of an IFT move is either its free rate or 0, when the position
+   ahead is taken, so the free rates are fixed upper bounds on the real
+   ones.  This engine samples candidate events from the bounds, exactly as
+   the grouped engine does without crowding (sets of anterograde and
+   retrograde IFTs, changed only when an IFT turns around), and only then
+   checks whether the candidate is blocked.  A blocked candidate is
+   rejected: time goes on at the bound rate and another candidate is drawn.
+   The bounds are never rebuilt, and only the candidate's neighbour is
+   looked at, so at low density a step costs about as much as a grouped one.
+   The waiting times of the trials are summed as the product of their
+   uniforms, so a step takes a single log however many candidates it
+   rejects.  The process is the same as with ift_step (whose null events
+   are the rejections).
+   Included by ift.c for the exclusion movement rule (IFT_MOVE).
+*/
+
+#ifndef RSSA_C_INCLUDED
+#define RSSA_C_INCLUDED
+
+#include "idset.c"
+#include "exclusion.c"
+
+/* The product of the uniforms is folded into the wait below this */
+#define RSSA_TINY 1e-280
+
+typedef struct{
+	unsigned n_ifts;
+	int * x;
+	unsigned head;
+	IdSet ante;
+	IdSet retro;
+} RssaState;
+/*RssaState: State of the rejection-based crowding engine
+
+n_ifts - Number of IFT's.
+x - IFT positions, in increasing order starting from x[head] and wrapping
+	around the end of the array (same notation as x0 in the InitialConditions
+	struct).
+head - index of the IFT closest to the retrograde end (-length).
+ante - IFTs moving anterograde (x >= 0), blocked or not.
+retro - IFTs moving retrograde (x < 0), blocked or not.
+*/
+
+
+void rssa_file( RssaState * s, const unsigned j )
+/* Puts IFT j in the set matching its direction. */
+{
+	if( s->x[j] >= 0 ){
+		idsRemove( &(s->retro), j );
+		idsInsert( &(s->ante), j );
+	}else{
+		idsRemove( &(s->ante), j );
+		idsInsert( &(s->retro), j );
+	}
+}
+
+void * rssa_create( const InitialConditions * const ic ){
+
+	RssaState * s = (RssaState *) malloc( sizeof(RssaState) );
+
+	s->n_ifts = ic->n_ifts;
+	s->x = (int *) malloc( ( ic->n_ifts + (ic->n_ifts == 0) ) * sizeof(int) );
+	s->ante = idsCreate( ic->n_ifts );
+	s->retro = idsCreate( ic->n_ifts );
+
+	return s;
+}
+
+void rssa_reset( void * state, const InitialConditions * const ic ){
+
+	RssaState * s = state;
+	unsigned i;
+
+	idsClear( &(s->ante) );
+	idsClear( &(s->retro) );
+
+	s->head = 0;
+	for( i = 0; i < s->n_ifts; i++ ){
+		s->x[i] = ic->x0[i];
+		if( s->x[i] < s->x[s->head] ) s->head = i;
+		idsInsert( s->x[i] >= 0 ? &(s->ante) : &(s->retro), i );
+	}
+}
+
+void rssa_destroy( void * state ){
+
+	RssaState * s = state;
+
+	idsDestroy( s->ante );
+	idsDestroy( s->retro );
+	free( s->x );
+	free( s );
+}
+
+int rssa_step( void * state, const Parameters * const p, Rng * rng,
+	const double time_limit, double * t, int * length )
+/*int rssa_step( void * state, const Parameters * const p, Rng * rng,
+	const double time_limit, double * t, int * length )
+Represents a single step of the simulation, with the same dynamics as
+ift_step except that blocked moves are rejected until one that happens (or
+the time limit) is reached.
+
+Return value:
+The change in length (+1, 0, or -1)
+*/
+{
+	RssaState * s = state;
+	const unsigned n = s->n_ifts;
+	unsigned j, k;
+	double temp;
+	double product = 1, wait = 0;
+	const double ante_rate = p->lambda_p * s->ante.size;
+	const double retro_rate = p->lambda_m * s->retro.size;
+	const double rate_sum = ante_rate + retro_rate
+		+ p->mu * can_disassemble( n, *length );
+	short length_change = 0;
+
+	if( rate_sum <= 0 ){ /* No IFTs and the length is 0 */
+		*t = time_limit;
+		return 0;
+	}
+
+	/* Draw candidates from the bounds until one is not blocked */
+	for( ;; ){
+		product *= rng_uniform_open( rng );
+		if( product < RSSA_TINY ){
+			wait -= log( product );
+			product = 1;
+			/* Every move may be blocked: give up past the time limit */
+			if( *t + wait / rate_sum > time_limit ){
+				j = n + 1;
+				break;
+			}
+		}
+
+		temp = rate_sum * rng_uniform( rng );
+
+		if( temp >= ante_rate + retro_rate ){ /* Disassembly */
+			j = n;
+			break;
+		}
+
+		j = temp < ante_rate ?
+			idsPick( &(s->ante), temp / ante_rate ) :
+			idsPick( &(s->retro), ( temp - ante_rate ) / retro_rate );
+
+		/* Accept unless blocked; an IFT at the tip can always move */
+		if( s->x[j] >= *length || s->x[ (j+1) % n ] != s->x[j] + 1 ) break;
+	}
+
+	/* Sum of the trials' waiting times */
+	*t += ( wait - log( product ) ) / rate_sum;
+
+	if( *t > time_limit || j > n ){
+		*t = time_limit;
+		return 0;
+	}
+
+	if( j == n ){ /* Disassembly */
+
+		/* Decrease Length. */
+		*length += ( length_change = -1 );
+
+		/* Move the IFTs on the disassembled segment, and file the moved
+		   ones again: those pushed onto the base turn anterograde. */
+		if( n > 0 ){
+			j = (s->head+n-1) % n;
+			for( k = push_down( s->x, n, *length, j ); k > 0; k-- ){
+				rssa_file( s, j );
+				j = (j+n-1) % n;
+			}
+
+			j = s->head;
+			for( k = push_up( s->x, n, *length, s->head ); k > 0; k-- ){
+				rssa_file( s, j );
+				j = (j+1) % n;
+			}
+		}
+
+	}else if( s->x[j] > *length - 1 ){ /* Then assembly occurs */
+
+		/* Increase length. */
+		*length += ( length_change = +1 );
+		/* Change direction on IFT, it is now the last one back */
+		s->x[j] = -(*length);
+		s->head = j;
+		rssa_file( s, j );
+
+	}else if( ++(s->x[j]) == 0 ) /* Reached the base */
+		rssa_file( s, j );
+
+	return length_change;
+}
+
+const Engine rssa_engine = { "rssa",
+	rssa_create, rssa_reset, rssa_step, rssa_destroy, 0 };
+
+#endif
@@ -0,0 +1,39 @@
+/* Author: Yuriy Sverchkov
+   File: run.c
+   Description: One run of the simulation, recording its trajectory.
+   Included by ift.c.  Ensembles do not come through here: interleave.c
+   steps their runs and records what IFT_RECORD says.
+*/
+
+void ift_run_trajectory( const Engine * const engine, void * state,
+	const Parameters * const p, Rng * rng,
+	const InitialConditions * const ic, RunRecord * record )
+/* Runs the simulation from the initial conditions to ic->time_limit with
+   the given engine state and generator, and records the final length and
+   every length change in record->times and record->lengths, which must
+   have been created. */
+{
+	int length = ic->length0; /*Current flagellum length*/
+	double t = 0; /*Current time*/
+	unsigned n_changes = 0; /*Length change counter*/
+
+	/* Sets Initial positions of IFT's. */
+	engine->reset( state, ic );
+
+	/* Sets "Step 0" times and lengths */
+	daSet( &(record->times), 0, 0 );
+	iaSet( &(record->lengths), 0, ic->length0 );
+
+	/*** Main Loop ***/
+	while( t < ic->time_limit ){
+		if( engine->step( state, p, rng, ic->time_limit, &t, &length ) != 0
+			|| t == ic->time_limit )
+		{
+			++n_changes;
+			daSet( &(record->times), n_changes, t );
+			iaSet( &(record->lengths), n_changes, length );
+		}
+	}
+
+	record->length = length;
+}
@@ -0,0 +1,230 @@
+/* Author: Yuriy Sverchkov
+   File: sfmt-period.c
+   Description: The SFMT recursion for one period, as a template.
+   rng.c includes this file once per period, after defining SFMT_MEXP and
+   including the matching SFMT-params<SFMT_MEXP>.h.  The shifts and masks
+   stay compile time constants (the SIMD shifts need immediates), and every
+   function gets the period as a suffix.  What is left is an RngPeriod named
+   sfmt_period_<SFMT_MEXP>.  The parameter macros are undefined at the end,
+   ready for the next period.
+*/
+
+#define SFMT_N ( SFMT_MEXP / 128 + 1 )
+#define SFMT_NAME( f ) RNG_PASTE( f, SFMT_MEXP )
+
+#if defined(HAVE_SSE2)
+
+static __m128i SFMT_NAME( sfmt_recursion_ )( __m128i a, __m128i b, __m128i c,
+	__m128i d, __m128i mask )
+/* SFMT recursion: one new block from a = w[i], b = w[i+POS1],
+   c = w[i-2] and d = w[i-1]. */
+{
+	__m128i x, y, z;
+
+	y = _mm_and_si128( _mm_srli_epi32( b, SR1 ), mask );
+	z = _mm_xor_si128( _mm_srli_si128( c, SR2 ), a );
+	z = _mm_xor_si128( z, _mm_slli_epi32( d, SL1 ) );
+	x = _mm_slli_si128( a, SL2 );
+	z = _mm_xor_si128( z, x );
+	return _mm_xor_si128( z, y );
+}
+
+static void SFMT_NAME( sfmt_regenerate_sse2_ )( RngBlock * w )
+/* Replaces the whole state with the next SFMT_N blocks. */
+{
+	int i;
+	__m128i r, r1 = w[SFMT_N-2].si, r2 = w[SFMT_N-1].si;
+	__m128i mask = _mm_set_epi32( MSK4, MSK3, MSK2, MSK1 );
+
+	for( i = 0; i < SFMT_N - POS1; i++ ){
+		r = SFMT_NAME( sfmt_recursion_ )( w[i].si, w[i+POS1].si, r1, r2, mask );
+		w[i].si = r;
+		r1 = r2;
+		r2 = r;
+	}
+	for( ; i < SFMT_N; i++ ){
+		r = SFMT_NAME( sfmt_recursion_ )( w[i].si, w[i+POS1-SFMT_N].si, r1, r2,
+			mask );
+		w[i].si = r;
+		r1 = r2;
+		r2 = r;
+	}
+}
+
+#if defined(RNG_DISPATCH)
+
+/* The recursion w[i] = a ^ (a << SL2) ^ ((b >> SR1) & mask) ^ (c >> SR2)
+   ^ (d << SL1), with a = w[i], b = w[i+POS1] (mod N), c = w[i-2] and
+   d = w[i-1], only chains from block to block through c and d.  The wide
+   versions compute the a and b terms for 2 (AVX2) or 4 (AVX-512) blocks at
+   once, since the 128-bit byte shifts work lane by lane, then finish the
+   blocks one by one.  b is always a block that is already final: old for
+   i < N-POS1, new after, as long as N-POS1 is at least the width. */
+
+static int SFMT_NAME( sfmt_pos1_ )( const int i ){
+	return i < SFMT_N - POS1 ? i + POS1 : i + POS1 - SFMT_N;
+}
+
+static void SFMT_NAME( sfmt_chain_ )( RngBlock * w, const int i,
+	const __m128i * t, const int width, __m128i * r1, __m128i * r2 )
+/* Finishes blocks i to i+width-1 from their a and b terms in t. */
+{
+	int j;
+	__m128i r;
+
+	for( j = 0; j < width; j++ ){
+		r = _mm_xor_si128( t[j], _mm_xor_si128( _mm_srli_si128( *r1, SR2 ),
+			_mm_slli_epi32( *r2, SL1 ) ) );
+		w[i+j].si = r;
+		*r1 = *r2;
+		*r2 = r;
+	}
+}
+
+__attribute__((target("avx2")))
+static void SFMT_NAME( sfmt_regenerate_avx2_ )( RngBlock * w )
+/* Same as the SSE2 version, two blocks at a time. */
+{
+	int i;
+	__m128i r1 = w[SFMT_N-2].si, r2 = w[SFMT_N-1].si, t[2];
+	const __m128i mask1 = _mm_set_epi32( MSK4, MSK3, MSK2, MSK1 );
+	const __m256i mask = _mm256_broadcastsi128_si256( mask1 );
+	__m256i a, b;
+
+	for( i = 0; i + 2 <= SFMT_N; i += 2 ){
+		a = _mm256_loadu_si256( (__m256i *) &( w[i] ) );
+		if( SFMT_NAME( sfmt_pos1_ )( i+1 ) == SFMT_NAME( sfmt_pos1_ )( i ) + 1 )
+			b = _mm256_loadu_si256( (__m256i *) &( w[ SFMT_NAME( sfmt_pos1_ )( i ) ] ) );
+		else /* b wraps around the end of the state */
+			b = _mm256_inserti128_si256( _mm256_castsi128_si256(
+				w[ SFMT_NAME( sfmt_pos1_ )( i ) ].si ),
+				w[ SFMT_NAME( sfmt_pos1_ )( i+1 ) ].si, 1 );
+		a = _mm256_xor_si256( _mm256_xor_si256( a, _mm256_slli_si256( a, SL2 ) ),
+			_mm256_and_si256( _mm256_srli_epi32( b, SR1 ), mask ) );
+		_mm256_storeu_si256( (__m256i *) t, a );
+		SFMT_NAME( sfmt_chain_ )( w, i, t, 2, &r1, &r2 );
+	}
+	for( ; i < SFMT_N; i++ ){
+		w[i].si = SFMT_NAME( sfmt_recursion_ )( w[i].si,
+			w[ SFMT_NAME( sfmt_pos1_ )( i ) ].si, r1, r2, mask1 );
+		r1 = r2;
+		r2 = w[i].si;
+	}
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void SFMT_NAME( sfmt_regenerate_avx512_ )( RngBlock * w )
+/* Same as the SSE2 version, four blocks at a time. */
+{
+	int i;
+	__m128i r1 = w[SFMT_N-2].si, r2 = w[SFMT_N-1].si, t[4];
+	const __m128i mask1 = _mm_set_epi32( MSK4, MSK3, MSK2, MSK1 );
+	const __m512i mask = _mm512_broadcast_i32x4( mask1 );
+	__m512i a, b;
+
+	for( i = 0; i + 4 <= SFMT_N; i += 4 ){
+		a = _mm512_loadu_si512( (void *) &( w[i] ) );
+		if( SFMT_NAME( sfmt_pos1_ )( i+3 ) == SFMT_NAME( sfmt_pos1_ )( i ) + 3 )
+			b = _mm512_loadu_si512( (void *) &( w[ SFMT_NAME( sfmt_pos1_ )( i ) ] ) );
+		else{ /* b wraps around the end of the state */
+			b = _mm512_castsi128_si512( w[ SFMT_NAME( sfmt_pos1_ )( i ) ].si );
+			b = _mm512_inserti32x4( b, w[ SFMT_NAME( sfmt_pos1_ )( i+1 ) ].si, 1 );
+			b = _mm512_inserti32x4( b, w[ SFMT_NAME( sfmt_pos1_ )( i+2 ) ].si, 2 );
+			b = _mm512_inserti32x4( b, w[ SFMT_NAME( sfmt_pos1_ )( i+3 ) ].si, 3 );
+		}
+		a = _mm512_xor_si512( _mm512_xor_si512( a, _mm512_bslli_epi128( a, SL2 ) ),
+			_mm512_and_si512( _mm512_srli_epi32( b, SR1 ), mask ) );
+		_mm512_storeu_si512( (void *) t, a );
+		SFMT_NAME( sfmt_chain_ )( w, i, t, 4, &r1, &r2 );
+	}
+	for( ; i < SFMT_N; i++ ){
+		w[i].si = SFMT_NAME( sfmt_recursion_ )( w[i].si,
+			w[ SFMT_NAME( sfmt_pos1_ )( i ) ].si, r1, r2, mask1 );
+		r1 = r2;
+		r2 = w[i].si;
+	}
+}
+
+#endif
+
+#else
+
+static void SFMT_NAME( sfmt_recursion_ )( uint32_t r[4], const uint32_t a[4],
+	const uint32_t b[4], const uint32_t c[4], const uint32_t d[4] )
+/* SFMT recursion: one new block from a = w[i], b = w[i+POS1],
+   c = w[i-2] and d = w[i-1]. */
+{
+	uint32_t x[4], y[4];
+	const uint32_t mask[4] = { MSK1, MSK2, MSK3, MSK4 };
+	int k;
+
+	rng_shift128( x, a, SL2 );
+	rng_shift128( y, c, -SR2 );
+	for( k = 0; k < 4; k++ )
+		r[k] = a[k] ^ x[k] ^ ((b[k] >> SR1) & mask[k]) ^ y[k] ^ (d[k] << SL1);
+}
+
+static void SFMT_NAME( sfmt_regenerate_ )( RngBlock * w )
+/* Replaces the whole state with the next SFMT_N blocks. */
+{
+	int i;
+	uint32_t * r1 = w[SFMT_N-2].u, * r2 = w[SFMT_N-1].u;
+
+	for( i = 0; i < SFMT_N - POS1; i++ ){
+		SFMT_NAME( sfmt_recursion_ )( w[i].u, w[i].u, w[i+POS1].u, r1, r2 );
+		r1 = r2;
+		r2 = w[i].u;
+	}
+	for( ; i < SFMT_N; i++ ){
+		SFMT_NAME( sfmt_recursion_ )( w[i].u, w[i].u, w[i+POS1-SFMT_N].u, r1, r2 );
+		r1 = r2;
+		r2 = w[i].u;
+	}
+}
+
+#endif
+
+const RngPeriod SFMT_NAME( sfmt_period_ ) = {
+	SFMT_MEXP,
+	SFMT_N,
+	{ PARITY1, PARITY2, PARITY3, PARITY4 },
+	IDSTR,
+#if defined(HAVE_SSE2)
+	SFMT_NAME( sfmt_regenerate_sse2_ ),
+#if defined(RNG_DISPATCH)
+	/* A vector of blocks must not need a b made in the same vector */
+	SFMT_N - POS1 >= 2 ? SFMT_NAME( sfmt_regenerate_avx2_ ) : NULL,
+	SFMT_N - POS1 >= 4 ? SFMT_NAME( sfmt_regenerate_avx512_ ) : NULL
+#else
+	NULL, NULL
+#endif
+#else
+	SFMT_NAME( sfmt_regenerate_ ), NULL, NULL
+#endif
+};
+
+#undef SFMT_N
+#undef SFMT_NAME
+#undef SFMT_MEXP
+#undef POS1
+#undef SL1
+#undef SL2
+#undef SR1
+#undef SR2
+#undef MSK1
+#undef MSK2
+#undef MSK3
+#undef MSK4
+#undef PARITY1
+#undef PARITY2
+#undef PARITY3
+#undef PARITY4
+#undef ALTI_SL1
+#undef ALTI_SR1
+#undef ALTI_MSK
+#undef ALTI_MSK64
+#undef ALTI_SL2_PERM
+#undef ALTI_SL2_PERM64
+#undef ALTI_SR2_PERM
+#undef ALTI_SR2_PERM64
+#undef IDSTR
@@ -0,0 +1,166 @@
+/* Author: Yuriy Sverchkov
+   File: small.c
+   Description: ift_step for a fixed number of IFT slots, as a template.
+   ift.c includes this file once per capacity and instruction set, after
+   defining SMALL_CAP (8, 16, 32 or 64) and SMALL_AVX2 (0 for SSE2, 1 for
+   AVX2).  The positions live in an aligned array of SMALL_CAP ints, the
+   unused slots holding SMALL_EMPTY, so every loop over the IFTs has a
+   constant trip count and is done with vector compares: the direction of
+   each IFT comes out as a bit mask, which gives the rates by counting bits
+   and the moving IFT by picking a bit.  The macros are undefined at the
+   end.
+*/
+
+#if SMALL_AVX2
+#define SMALL_NAME( f ) RNG_PASTE( RNG_PASTE( f, SMALL_CAP ), _avx2 )
+#define SMALL_TARGET __attribute__((target("avx2,bmi2")))
+#else
+#define SMALL_NAME( f ) RNG_PASTE( RNG_PASTE( f, SMALL_CAP ), _sse2 )
+#define SMALL_TARGET
+#endif
+
+SMALL_TARGET
+static uint64_t SMALL_NAME( small_ante_ )( const int x[] )
+/* Returns the mask of the slots holding an anterograde IFT (x >= 0). */
+{
+	uint64_t mask = 0;
+	int i;
+#if SMALL_AVX2
+	const __m256i minus1 = _mm256_set1_epi32( -1 );
+
+	for( i = 0; i < SMALL_CAP; i += 8 )
+		mask |= (uint64_t) _mm256_movemask_ps( _mm256_castsi256_ps(
+			_mm256_cmpgt_epi32( _mm256_load_si256( (const __m256i *)( x + i ) ),
+			minus1 ) ) ) << i;
+#else
+	const __m128i minus1 = _mm_set1_epi32( -1 );
+
+	for( i = 0; i < SMALL_CAP; i += 4 )
+		mask |= (uint64_t) _mm_movemask_ps( _mm_castsi128_ps(
+			_mm_cmpgt_epi32( _mm_load_si128( (const __m128i *)( x + i ) ),
+			minus1 ) ) ) << i;
+#endif
+	return mask;
+}
+
+SMALL_TARGET
+static void SMALL_NAME( small_disassemble_ )( int x[], const int length )
+/* Moves the IFTs on the disassembled segment (at length+1 and
+   -(length+1)) down to the new length. */
+{
+	int i;
+#if SMALL_AVX2
+	const __m256i tip = _mm256_set1_epi32( length + 1 );
+	const __m256i end = _mm256_set1_epi32( -length - 1 );
+	__m256i v;
+
+	/* A true compare is -1: add it at the tip, subtract it at the end */
+	for( i = 0; i < SMALL_CAP; i += 8 ){
+		v = _mm256_load_si256( (const __m256i *)( x + i ) );
+		v = _mm256_sub_epi32( _mm256_add_epi32( v, _mm256_cmpeq_epi32( v, tip ) ),
+			_mm256_cmpeq_epi32( v, end ) );
+		_mm256_store_si256( (__m256i *)( x + i ), v );
+	}
+#else
+	const __m128i tip = _mm_set1_epi32( length + 1 );
+	const __m128i end = _mm_set1_epi32( -length - 1 );
+	__m128i v;
+
+	/* A true compare is -1: add it at the tip, subtract it at the end */
+	for( i = 0; i < SMALL_CAP; i += 4 ){
+		v = _mm_load_si128( (const __m128i *)( x + i ) );
+		v = _mm_sub_epi32( _mm_add_epi32( v, _mm_cmpeq_epi32( v, tip ) ),
+			_mm_cmpeq_epi32( v, end ) );
+		_mm_store_si128( (__m128i *)( x + i ), v );
+	}
+#endif
+}
+
+#if SMALL_AVX2
+SMALL_TARGET
+static unsigned SMALL_NAME( small_select_ )( const uint64_t mask,
+	const double r )
+/* Same as small_select, with the bit deposit instruction. */
+{
+	const unsigned n = small_sums( mask ) >> 56;
+	const unsigned k = r < n ? (unsigned) r : n - 1;
+
+	return __builtin_ctzll( _pdep_u64( (uint64_t) 1 << k, mask ) );
+}
+#define SMALL_SELECT SMALL_NAME( small_select_ )
+#else
+#define SMALL_SELECT small_select
+#endif
+
+SMALL_TARGET
+static int SMALL_NAME( small_step_ )( int x[], const unsigned n_ifts,
+	const Parameters * const p, Rng * rng, const double time_limit,
+	double * t, int * length )
+/* Same as ift_step (free movement) on SMALL_CAP slots of which the first
+   n_ifts hold IFTs. */
+{
+	const uint64_t used = n_ifts >= 64 ? ~(uint64_t) 0
+		: ( (uint64_t) 1 << n_ifts ) - 1;
+	const uint64_t ante = SMALL_NAME( small_ante_ )( x );
+	const unsigned n_ante = small_sums( ante ) >> 56;
+	const double ante_rate = p->lambda_p * n_ante;
+	const double retro_rate = p->lambda_m * ( n_ifts - n_ante );
+	const double rate_sum = ante_rate + retro_rate + p->mu * ( *length > 0 );
+	double tau, temp;
+	unsigned j;
+	int forward;
+	short length_change = 0;
+
+	if( rate_sum <= 0 ){ /* Impossible */
+		tau = time_limit - *t;
+		printf( "The sum of rates was nonpositive (%g).", rate_sum );
+	}else{
+		/* Get time until next event */
+		tau = ift_wait( rng ) / rate_sum;
+
+		/* Check if next event is within the time limit */
+		if( tau + *t > time_limit )
+			tau = time_limit - *t;
+		else{
+			/* Pick next event: an IFT of a direction, then which one */
+
+			temp = rate_sum * rng_uniform( rng );
+
+			if( temp < ante_rate + retro_rate ){ /* Move IFT */
+
+				/* The direction is as likely as not: no branch on it */
+				forward = temp < ante_rate;
+				j = SMALL_SELECT( forward ? ante : used & ~ante,
+					( forward ? temp : temp - ante_rate )
+					/ ( forward ? p->lambda_p : p->lambda_m ) );
+
+				if( ++x[j] > *length ){ /* Then assembly occurs */
+
+					/* Increase length. */
+					*length += ( length_change = +1 );
+					/* Change direction on IFT */
+					x[j] = -(*length);
+				}
+
+			}else{ /* Disassembly */
+
+				/* Decrease Length. */
+				*length += ( length_change = -1 );
+
+				/* Move IFTs on Disassembled segment down. */
+				SMALL_NAME( small_disassemble_ )( x, *length );
+			}
+		}
+	}
+
+	/* Update time */
+	*t += tau;
+
+	return length_change;
+}
+
+#undef SMALL_NAME
+#undef SMALL_TARGET
+#undef SMALL_SELECT
+#undef SMALL_CAP
+#undef SMALL_AVX2
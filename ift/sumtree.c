@@ -0,0 +1,82 @@
+/* Author: Yuriy Sverchkov
+   File: sumtree.c
+   Description: Implements sum trees of rates, which support changing a rate
+   and finding the cell in which a point of [0,total) falls in logarithmic
+   time.  Every node holds the sum of its two children, recomputed from them
+   on each change, so unlike a Fenwick tree of doubles the sums do not drift
+   however many changes are made.
+*/
+
+#ifndef SUMTREE_C_INCLUDED
+#define SUMTREE_C_INCLUDED
+
+#include <stdlib.h>
+
+typedef struct {
+	unsigned int size;/*Number of cells*/
+	unsigned int leaves;/*Smallest power of two not below size*/
+	double * tree;/*tree[1] is the root, tree[k] is the sum of tree[2k] and tree[2k+1], cell i is tree[leaves+i]*/
+} SumTree;
+
+SumTree stCreate( const unsigned int size )
+/* Creates a sum tree of the specified size with all rates zero. */
+{
+	unsigned int i;
+	SumTree result;
+
+	for( result.leaves = 1; result.leaves < size; result.leaves *= 2 );
+	result.tree = (double *) malloc( 2 * result.leaves * sizeof(double) );
+	result.size = size;
+
+	for( i = 0; i < 2 * result.leaves; i++ )
+		result.tree[i] = 0;
+
+	return result;
+}
+
+void stDestroy( SumTree t )
+/* Deallocates a sum tree's dynamic contents. */
+{
+	free(t.tree);
+	return;
+}
+
+void stSet( SumTree * t, const unsigned int index, const double rate )
+/* Sets the rate in cell index. */
+{
+	unsigned int k = t->leaves + index;
+
+	t->tree[k] = rate;
+	for( k /= 2; k > 0; k /= 2 )
+		t->tree[k] = t->tree[2*k] + t->tree[2*k+1];
+	return;
+}
+
+double stGet( const SumTree * t, const unsigned int index ){
+	return t->tree[ t->leaves + index ];
+}
+
+double stTotal( const SumTree * t ){
+	return t->tree[1];
+}
+
+unsigned int stFind( const SumTree * t, double u )
+/* Returns the cell i such that the rates in cells 0 to i-1 sum to at most u
+   and those in cells 0 to i to more, for u in [0,total).  Never returns a
+   cell of rate zero, even if rounding puts u at or past the total.  The
+   total must be positive. */
+{
+	unsigned int k = 1;
+
+	while( k < t->leaves )
+		if( u < t->tree[2*k] || t->tree[2*k+1] <= 0 )
+			k = 2*k;
+		else{
+			u -= t->tree[2*k];
+			k = 2*k + 1;
+		}
+
+	return k - t->leaves;
+}
+
+#endif
@@ -0,0 +1,257 @@
+/* Author: Yuriy Sverchkov
+   Filename: tauleap.c
+   Purpose: Tau-leaping engine for the IFT simulation, approximate.
+   A step is a leap of time tau over which the length is held fixed, as in
+   tau-leaping (Gillespie, 2001).  Without crowding the IFTs do not interact,
+   so within a leap each one walks on its own, as in the round-trip engine:
+   the time at which it next turns around is an Erlang number of hops away,
+   and if that is past the end of the leap, where it stands at the end is a
+   binomial split of the hops it would have made (see roundtrip.c).  An IFT
+   reaching the tip is an assembly.  The leap's disassemblies are a Poisson
+   count, at most the length.  The assemblies and disassemblies are applied
+   together at the end of the leap, and the IFTs beyond the new tip are
+   pushed back onto it.
+   The leap size is chosen so that the expected change and the standard
+   deviation of the length stay within LEAP_EPSILON times the length (Cao,
+   Gillespie and Petzold, 2006), with the assembly rate estimated as one per
+   round trip of each IFT.  The lengths have about the distribution of
+   ift_step's; the larger the length, the longer the leaps.
+   Each state counts its leaps, hops, assemblies and disassemblies over its
+   runs, and the engine reports them.  It also keeps the assemblies and
+   disassemblies of its last leap, which ensembles record, since a leap's
+   change in length is only their difference (see Engine).
+   Included by ift.c for the free movement rule (IFT_MOVE).
+*/
+
+#ifndef TAULEAP_C_INCLUDED
+#define TAULEAP_C_INCLUDED
+
+#include "randist.c"
+
+/* Largest expected relative change of the length in a leap (can be set at
+   build time) */
+#ifndef LEAP_EPSILON
+#define LEAP_EPSILON 0.01
+#endif
+
+typedef struct{
+	unsigned n_ifts;
+	int * x;
+	const double * speed;
+	int64_t leaps;
+	double leap_time;
+	double hops;
+	int64_t assemblies;
+	int64_t disassemblies;
+	int64_t dropped;
+	int last_assemblies;
+	int last_disassemblies;
+} TauLeapState;
+/*TauLeapState: State of the tau-leaping engine
+
+n_ifts - Number of IFT's.
+x - IFT positions (same notation as x0 in the InitialConditions struct).
+speed - the IFTs' speeds, from the initial conditions.
+leaps, leap_time, hops, assemblies, disassemblies - the number of leaps, the
+	time they covered and the events in them, over every run of the state.
+dropped - disassemblies drawn past length 0, which do not take place.
+last_assemblies, last_disassemblies - those of the last leap (see Engine).
+*/
+
+
+void * tauleap_create( const InitialConditions * const ic ){
+
+	TauLeapState * s = (TauLeapState *) malloc( sizeof(TauLeapState) );
+
+	s->n_ifts = ic->n_ifts;
+	s->x = (int *) malloc( ( ic->n_ifts + (ic->n_ifts == 0) ) * sizeof(int) );
+	s->leaps = s->assemblies = s->disassemblies = s->dropped = 0;
+	s->last_assemblies = s->last_disassemblies = 0;
+	s->leap_time = s->hops = 0;
+
+	return s;
+}
+
+void tauleap_reset( void * state, const InitialConditions * const ic ){
+
+	TauLeapState * s = state;
+	unsigned i;
+
+	for( i = 0; i < s->n_ifts; i++ ) s->x[i] = ic->x0[i];
+	s->speed = ic->speed;
+}
+
+void tauleap_destroy( void * state ){
+
+	TauLeapState * s = state;
+
+	free( s->x );
+	free( s );
+}
+
+void tauleap_report( void * const states[], const unsigned n ){
+
+	const TauLeapState * s;
+	int64_t leaps = 0, assemblies = 0, disassemblies = 0, dropped = 0;
+	double leap_time = 0, hops = 0;
+	unsigned i;
+
+	for( i = 0; i < n; i++ ){
+		s = states[i];
+		leaps += s->leaps;
+		leap_time += s->leap_time;
+		hops += s->hops;
+		assemblies += s->assemblies;
+		disassemblies += s->disassemblies;
+		dropped += s->dropped;
+	}
+	if( leaps == 0 ) return;
+
+	printf( "Leaps: %lld, %g s long on average, with %g hops, %g assemblies and"
+		" %g disassemblies each (%lld disassemblies dropped at length 0).\n",
+		(long long) leaps, leap_time / leaps, hops / leaps,
+		(double) assemblies / leaps, (double) disassemblies / leaps,
+		(long long) dropped );
+}
+
+int tauleap_walk( TauLeapState * s, const Parameters * const p, Rng * rng,
+	const unsigned i, double left, const int length )
+/* Moves IFT i for the time left at the given length.  Returns the number of
+   assemblies. */
+{
+	const double speed = s->speed ? s->speed[i] : 1;
+	double rate, time;
+	unsigned hops;
+	int assemblies = 0;
+
+	for( ;; ){
+		rate = speed * ( s->x[i] >= 0 ? p->lambda_p : p->lambda_m );
+		if( rate <= 0 ) return assemblies;
+
+		/* Hops to the next turn, and when it comes */
+		hops = s->x[i] >= 0 ? length - s->x[i] + 1 : -(s->x[i]);
+		time = rand_erlang( rng, hops, rate );
+
+		if( time > left ){ /* Stops on the way */
+			if( hops > 1 ){
+				hops = rand_binomial( rng, hops - 1, left / time );
+				s->x[i] += hops;
+				s->hops += hops;
+			}
+			return assemblies;
+		}
+
+		left -= time;
+		s->hops += hops;
+		if( s->x[i] >= 0 ){ /* Then assembly occurs */
+			++assemblies;
+			s->x[i] = -length-1;
+		}else /* Reached the base */
+			s->x[i] = 0;
+	}
+}
+
+double tauleap_bound( const int length )
+/* Returns the largest change of the length allowed in a leap. */
+{
+	return LEAP_EPSILON * length > 1 ? LEAP_EPSILON * length : 1;
+}
+
+double tauleap_size( const TauLeapState * s, const Parameters * const p,
+	const double time_left, const int length )
+/* Returns the length of the next leap, at most time_left. */
+{
+	const double disassembly = length > 0 ? p->mu : 0;
+	const double bound = tauleap_bound( length );
+	double speed, assembly = 0, drift, spread, tau = time_left;
+	unsigned i;
+
+	/* Assembly rate: one per round trip of each IFT */
+	if( p->lambda_p > 0 && p->lambda_m > 0 )
+		for( i = 0; i < s->n_ifts; i++ )
+			if( ( speed = s->speed ? s->speed[i] : 1 ) > 0 )
+				assembly += speed / ( ( length + 1 ) / p->lambda_p
+					+ length / p->lambda_m );
+
+	drift = fabs( assembly - disassembly );
+	spread = assembly + disassembly;
+	if( drift * tau > bound ) tau = bound / drift;
+	if( spread * tau > bound * bound ) tau = bound * bound / spread;
+
+	return tau;
+}
+
+int tauleap_leap( TauLeapState * s, const Parameters * const p, Rng * rng,
+	const double tau, double * t, int * length )
+/* Leaps over tau.  Returns the net change in length. */
+{
+	const unsigned n = s->n_ifts;
+	int tip, assemblies = 0, change;
+	unsigned i, disassemblies = 0;
+
+	/* The IFTs' walks */
+	for( i = 0; i < n; i++ )
+		assemblies += tauleap_walk( s, p, rng, i, tau, *length );
+	tip = *length + assemblies;
+
+	/* Disassemblies, at the end of the leap */
+	if( *length > 0 && p->mu > 0 ){
+		disassemblies = rand_poisson( rng, p->mu * tau );
+		if( disassemblies > (unsigned) tip ){
+			s->dropped += disassemblies - tip;
+			disassemblies = tip;
+		}
+		tip -= disassemblies;
+
+		/* Move IFTs on Disassembled segment down. */
+		for( i = 0; i < n; i++ )
+			if( s->x[i] > tip ) s->x[i] = tip;
+			else if( s->x[i] < -tip ) s->x[i] = -tip;
+	}
+
+	++(s->leaps);
+	s->leap_time += tau;
+	s->assemblies += assemblies;
+	s->disassemblies += disassemblies;
+	s->last_assemblies = assemblies;
+	s->last_disassemblies = disassemblies;
+
+	*t += tau;
+	change = tip - *length;
+	*length = tip;
+
+	return change;
+}
+
+void tauleap_counts( const void * state, int64_t * assemblies,
+	int64_t * disassemblies )
+/* Gives the assemblies and disassemblies of the last leap. */
+{
+	const TauLeapState * s = state;
+
+	*assemblies = s->last_assemblies;
+	*disassemblies = s->last_disassemblies;
+}
+
+int tauleap_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+/*int tauleap_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+Leaps over an interval in which the length changes by about LEAP_EPSILON
+of itself at most.
+
+Return value:
+The net change in length over the leap
+*/
+{
+	TauLeapState * s = state;
+
+	return tauleap_leap( s, p, rng,
+		tauleap_size( s, p, time_limit - *t, *length ), t, length );
+}
+
+const Engine tauleap_engine = { "tauleap",
+	tauleap_create, tauleap_reset, tauleap_step, tauleap_destroy, 1,
+	tauleap_report, tauleap_counts };
+
+#endif
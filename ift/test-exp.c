@@ -0,0 +1,110 @@
+/* Author: Yuriy Sverchkov
+   Filename: test-exp.c
+   Purpose: Checks the exponential sampler (rand_exp and rand_exp_fill in
+   randist.c) against the exponential distribution: mean and variance, a
+   chi-square test on equiprobable bins, the Kolmogorov-Smirnov distance,
+   and the frequency of the tail beyond ZIG_TAIL.  Prints the statistics and
+   exits with 1 if any of them is off.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "randist.c"
+
+#define N_DRAWS 10000000
+#define N_BINS 1000
+#define BATCH 1000
+
+int compare_doubles( const void * a, const void * b ){
+	const double x = *(const double *) a, y = *(const double *) b;
+	return ( x > y ) - ( x < y );
+}
+
+int check( const char * name, double x[], const unsigned n )
+/* Tests n exponential variates and prints the results.  Returns the number
+   of failed tests.  Sorts x. */
+{
+	unsigned i, bin, tail = 0, count[N_BINS];
+	double sum = 0, sum2 = 0, mean, var, chi2 = 0, d, ks = 0, e, z;
+	int failures = 0;
+
+	for( i = 0; i < N_BINS; i++ ) count[i] = 0;
+
+	for( i = 0; i < n; i++ ){
+		if( !( x[i] >= 0 ) || x[i] > 1e3 ){
+			printf( "%s: bad variate %g\n", name, x[i] );
+			return 1;
+		}
+		sum += x[i];
+		sum2 += x[i] * x[i];
+		/* Bins of equal probability: P(X < x) = 1 - exp(-x) */
+		bin = (unsigned)( ( 1 - exp( -x[i] ) ) * N_BINS );
+		++count[ bin < N_BINS ? bin : N_BINS - 1 ];
+		tail += x[i] > ZIG_TAIL;
+	}
+	mean = sum / n;
+	var = sum2 / n - mean * mean;
+
+	for( i = 0; i < N_BINS; i++ ){
+		d = count[i] - (double) n / N_BINS;
+		chi2 += d * d / ( (double) n / N_BINS );
+	}
+
+	/* Kolmogorov-Smirnov distance from the sorted sample */
+	qsort( x, n, sizeof(double), compare_doubles );
+	for( i = 0; i < n; i++ ){
+		e = 1 - exp( -x[i] );
+		if( e - (double) i / n > ks ) ks = e - (double) i / n;
+		if( (double)( i + 1 ) / n - e > ks ) ks = (double)( i + 1 ) / n - e;
+	}
+
+	printf( "%s: mean %.5f, variance %.5f, chi2 %.1f (%d bins), KS %.2e, "
+		"tail %u (expected %.0f)\n", name, mean, var, chi2, N_BINS, ks,
+		tail, n * exp( -ZIG_TAIL ) );
+
+	/* Five standard errors; the variance of the sample variance is
+	   (mu4 - sigma^4)/n = 8/n */
+	if( fabs( mean - 1 ) > 5 / sqrt( n ) ){ printf( "  mean off\n" ); ++failures; }
+	if( fabs( var - 1 ) > 5 * sqrt( 8.0 / n ) ){ printf( "  variance off\n" ); ++failures; }
+	/* chi2 with N_BINS-1 degrees of freedom: mean N_BINS-1, sd sqrt(2(N_BINS-1)) */
+	z = ( chi2 - ( N_BINS - 1 ) ) / sqrt( 2.0 * ( N_BINS - 1 ) );
+	if( z > 5 ){ printf( "  chi2 off\n" ); ++failures; }
+	/* KS: P( sqrt(n) D > 1.95 ) < 0.001 */
+	if( ks * sqrt( n ) > 1.95 ){ printf( "  KS off\n" ); ++failures; }
+	e = n * exp( -ZIG_TAIL );
+	if( fabs( tail - e ) > 5 * sqrt( e ) ){ printf( "  tail off\n" ); ++failures; }
+
+	return failures;
+}
+
+int main( int argc, char* argv[] ){
+
+	double * x = (double *) malloc( N_DRAWS * sizeof(double) );
+	Rng * rng = rng_create();
+	unsigned i;
+	int failures = 0;
+
+	rng_init( rng, 4357 );
+
+	/* One at a time */
+	for( i = 0; i < N_DRAWS; i++ ) x[i] = rand_exp( rng );
+	failures += check( "rand_exp", x, N_DRAWS );
+
+	/* In batches of odd sizes, so the SIMD path starts at any alignment */
+	for( i = 0; i < N_DRAWS; i += BATCH - 3 )
+		rand_exp_fill( rng, x + i,
+			N_DRAWS - i < BATCH - 3 ? N_DRAWS - i : BATCH - 3 );
+	failures += check( "rand_exp_fill", x, N_DRAWS );
+
+	/* From dSFMT's words */
+	rng_init_double( rng, 4357 );
+	for( i = 0; i < N_DRAWS; i++ ) x[i] = rand_exp( rng );
+	failures += check( "rand_exp (dSFMT)", x, N_DRAWS );
+
+	free( x );
+	rng_destroy( rng );
+
+	printf( "%d failures\n", failures );
+	return failures > 0;
+}
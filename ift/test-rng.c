@@ -0,0 +1,96 @@
+/* Author: Yuriy Sverchkov
+   Filename: test-rng.c
+   Purpose: Checks every period of SFMT in rng.c against the reference
+   output that comes with SFMT (../SFMT-src-1.3/SFMT.<mexp>.out.txt): the
+   first 1000 32-bit numbers after init_gen_rand(1234) and after
+   init_by_array({0x1234, 0x5678, 0x9abc, 0xdef0}), with each width of the
+   recursion the processor supports.  Prints one line per period and exits
+   with 1 on any mismatch.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rng.c"
+
+#define COUNT 1000
+
+int read_section( FILE * file, const char * title, uint32_t out[] )
+/* Reads the COUNT numbers after the line title.  Returns 0 on success. */
+{
+	char line[256];
+	unsigned long x;
+	int i;
+
+	while( fgets( line, sizeof(line), file ) )
+		if( strncmp( line, title, strlen( title ) ) == 0 ){
+			for( i = 0; i < COUNT; i++ ){
+				if( fscanf( file, "%lu", &x ) != 1 ) return 1;
+				out[i] = (uint32_t) x;
+			}
+			return 0;
+		}
+	return 1;
+}
+
+int compare( const char * name, Rng * rng, const uint32_t expected[] )
+/* Returns the number of outputs of rng that differ from expected. */
+{
+	int i, wrong = 0;
+
+	for( i = 0; i < COUNT; i++ )
+		if( rng_uint32( rng ) != expected[i] ){
+			if( !wrong ) printf( "  %s: output %d differs\n", name, i );
+			++wrong;
+		}
+	return wrong;
+}
+
+int main( int argc, char* argv[] ){
+
+	const uint32_t key[4] = { 0x1234, 0x5678, 0x9abc, 0xdef0 };
+	uint32_t linear[COUNT], array[COUNT];
+	Rng * rng = rng_create();
+	char path[64], id[128];
+	FILE * file;
+	int i, width, widest, failures = 0;
+
+	/* The widest recursion the processor runs */
+	rng_dispatch();
+	widest = rng_width ? rng_width : 1;
+
+	for( i = 0; rng_periods[i]; i++ ){
+
+		sprintf( path, "../SFMT-src-1.3/SFMT.%d.out.txt", rng_periods[i]->mexp );
+		if( !( file = fopen( path, "r" ) ) ){
+			printf( "Can't open %s\n", path );
+			return 1;
+		}
+		if( !fgets( id, sizeof(id), file )
+			|| strncmp( id, rng_periods[i]->idstr, strlen( rng_periods[i]->idstr ) )
+			|| read_section( file, "init_gen_rand", linear )
+			|| read_section( file, "init_by_array", array ) ){
+			printf( "%s is not the output of %s\n", path, rng_periods[i]->idstr );
+			return 1;
+		}
+		fclose( file );
+
+		printf( "%s:", rng_periods[i]->idstr );
+		for( width = 1; width <= widest; width *= 2 ){
+			if( ( width == 2 && !rng_periods[i]->regenerate_avx2 )
+				|| ( width == 4 && !rng_periods[i]->regenerate_avx512 ) ) continue;
+			rng_width = width;
+			rng_init_period( rng, rng_periods[i], 1234 );
+			failures += compare( "init_gen_rand", rng, linear );
+			rng_init_period_by_array( rng, rng_periods[i], key, 4 );
+			failures += compare( "init_by_array", rng, array );
+			printf( " %d", width );
+		}
+		printf( "\n" );
+	}
+
+	rng_destroy( rng );
+
+	printf( "%d failures\n", failures );
+	return failures > 0;
+}
@@ -0,0 +1,180 @@
+/* Author: Yuriy Sverchkov
+   Filename: unblocked.c
+   Purpose: Rejection-free engine for the IFT simulation with crowding.
+   ift_step gives a blocked IFT (one whose next position is taken) its full
+   rate and then does nothing when its move is picked.  This engine keeps
+   the sets of unblocked anterograde and unblocked retrograde IFTs up to
+   date as IFTs move, and only samples among moves that actually happen.
+   Leaving out the null events changes neither the order of the real events
+   nor the distribution of the time between them (the waiting time to the
+   next real event is exponential with the rate of the real events), so the
+   process is the same.
+   Included by ift.c for the exclusion movement rule (IFT_MOVE).
+*/
+
+#ifndef UNBLOCKED_C_INCLUDED
+#define UNBLOCKED_C_INCLUDED
+
+#include "idset.c"
+#include "exclusion.c"
+
+typedef struct{
+   unsigned n_ifts;
+   int * x;
+   unsigned head;
+   IdSet ante;
+   IdSet retro;
+} UnblockedState;
+/*UnblockedState: State of the rejection-free crowding engine
+
+n_ifts - Number of IFT's.
+x - IFT positions, in increasing order starting from x[head] and wrapping
+   around the end of the array (same notation as x0 in the InitialConditions
+   struct).
+head - index of the IFT closest to the retrograde end (-length).
+ante - unblocked IFTs moving anterograde (x >= 0).
+retro - unblocked IFTs moving retrograde (x < 0).
+*/
+
+
+void unblocked_update( UnblockedState * s, const unsigned j,
+   const int length )
+/* Puts IFT j in the set matching its direction if it can move, and takes it
+   out of both sets otherwise.  An IFT at the tip can always move. */
+{
+   const int x = s->x[j];
+
+   idsRemove( &(s->ante), j );
+   idsRemove( &(s->retro), j );
+
+   if( x >= length || s->x[ (j+1) % s->n_ifts ] != x + 1 )
+      idsInsert( x >= 0 ? &(s->ante) : &(s->retro), j );
+}
+
+void * unblocked_create( const InitialConditions * const ic ){
+
+   UnblockedState * s = (UnblockedState *) malloc( sizeof(UnblockedState) );
+
+   s->n_ifts = ic->n_ifts;
+   s->x = (int *) malloc( ( ic->n_ifts + (ic->n_ifts == 0) ) * sizeof(int) );
+   s->ante = idsCreate( ic->n_ifts );
+   s->retro = idsCreate( ic->n_ifts );
+
+   return s;
+}
+
+void unblocked_reset( void * state, const InitialConditions * const ic ){
+
+   UnblockedState * s = state;
+   unsigned i;
+
+   s->head = 0;
+   for( i = 0; i < s->n_ifts; i++ ){
+      s->x[i] = ic->x0[i];
+      if( s->x[i] < s->x[s->head] ) s->head = i;
+   }
+
+   for( i = 0; i < s->n_ifts; i++ )
+      unblocked_update( s, i, ic->length0 );
+}
+
+void unblocked_destroy( void * state ){
+
+   UnblockedState * s = state;
+
+   idsDestroy( s->ante );
+   idsDestroy( s->retro );
+   free( s->x );
+   free( s );
+}
+
+int unblocked_step( void * state, const Parameters * const p, Rng * rng,
+   const double time_limit, double * t, int * length )
+/*int unblocked_step( void * state, const Parameters * const p, Rng * rng,
+   const double time_limit, double * t, int * length )
+Represents a single step of the simulation, with the same dynamics as
+ift_step except that blocked moves are never picked.
+
+Return value:
+The change in length (+1, 0, or -1)
+*/
+{
+   UnblockedState * s = state;
+   const unsigned n = s->n_ifts;
+   unsigned j, k;
+   double temp;
+   double tau = 0;
+   double ante_rate = p->lambda_p * s->ante.size;
+   double retro_rate = p->lambda_m * s->retro.size;
+   double rate_sum = ante_rate + retro_rate
+      + p->mu * can_disassemble( n, *length );
+   short length_change = 0;
+
+   if( rate_sum <= 0 ){ /* Every IFT is blocked and the length is 0 */
+      tau = time_limit - *t;
+   }else{
+      /* Get time until next event */
+      tau = ift_wait( rng ) / rate_sum;
+
+      /* Check if next event is within the time limit */
+      if( tau + *t > time_limit )
+         tau = time_limit - *t;
+
+      else{ /* Pick next event */
+
+         temp = rate_sum * rng_uniform( rng );
+
+         if( temp < ante_rate + retro_rate ){ /* Move IFT */
+
+            j = temp < ante_rate ?
+               idsPick( &(s->ante), temp / ante_rate ) :
+               idsPick( &(s->retro), ( temp - ante_rate ) / retro_rate );
+
+            if( s->x[j] > *length - 1 ){ /* Then assembly occurs */
+
+               /* Increase length. */
+               *length += ( length_change = +1 );
+               /* Change direction on IFT, it is now the last one back */
+               s->x[j] = -(*length);
+               s->head = j;
+
+            }else ++(s->x[j]);
+
+            /* The IFT behind j may have been waiting for it */
+            unblocked_update( s, j, *length );
+            unblocked_update( s, (j+n-1) % n, *length );
+
+         }else if( n > 0 ){ /* Disassembly */
+
+            /* Decrease Length. */
+            *length += ( length_change = -1 );
+
+            /* Move the IFTs on the disassembled segment, then refresh the
+               moved blocks and the IFT behind each of them. */
+            j = (s->head+n-1) % n;
+            for( k = push_down( s->x, n, *length, j ) + 1; k > 0; k-- ){
+               unblocked_update( s, j, *length );
+               j = (j+n-1) % n;
+            }
+
+            j = (s->head+n-1) % n;
+            for( k = push_up( s->x, n, *length, s->head ) + 1; k > 0; k-- ){
+               unblocked_update( s, j, *length );
+               j = (j+1) % n;
+            }
+
+         }else /* Disassembly with no IFTs to push */
+            *length += ( length_change = -1 );
+      }
+   }
+
+   /* Update time */
+   *t += tau;
+
+   return length_change;
+}
+
+const Engine unblocked_engine = { "unblocked",
+   unblocked_create, unblocked_reset, unblocked_step, unblocked_destroy, 0 };
+
+#endif
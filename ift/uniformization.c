@@ -0,0 +1,265 @@
+/* Author: Yuriy Sverchkov
+   Filename: uniformization.c
+   Purpose: Uniformization engine for the IFT simulation (Jensen, 1953).
+   Every IFT moves at most at max(lambda_p,lambda_m) times the largest speed
+   and the flagellum disassembles at most at mu, so the total rate never
+   exceeds the constant Lambda = n_ifts*max(lambda_p,lambda_m)*max(speed)+mu.
+   The engine runs a Poisson process of ticks at Lambda and thins it: each
+   tick falls in the slot of one IFT or of the disassembly, and is that event
+   with probability its rate over the slot, or else a self-loop.  Blocked
+   moves under crowding, the slower direction, slower IFTs and disassembly at
+   length 0 are self-loops, so no rate is ever recomputed.
+   Ticks come in batches over intervals of UNIF_BATCH ticks on average: the
+   number of ticks is a Poisson draw, their times are sorted uniforms over
+   the interval and their slots are scaled uniforms, all filled in plain
+   loops over the batch.  No waiting time is drawn.  The process is the same
+   as with ift_step; a step goes on through self-loops up to the next real
+   event, so only those are counted.
+   Included by ift.c for either movement rule (IFT_MOVE).
+*/
+
+#ifndef UNIFORMIZATION_C_INCLUDED
+#define UNIFORMIZATION_C_INCLUDED
+
+#if IFT_MOVE == MOVE_EXCLUSION
+#include "exclusion.c"
+#endif
+
+/* Mean number of ticks per batch */
+#define UNIF_BATCH 64
+
+typedef struct{
+	unsigned n_ifts;
+	int * x;
+	unsigned head;
+	const double * speed;
+	double top_speed;
+	unsigned capacity;
+	double * tick;
+	double * slot;
+	double * scratch;
+	unsigned * bucket;
+	unsigned next;
+	unsigned n_ticks;
+	double end;
+	short ticking;
+} UniformizationState;
+/*UniformizationState: State of the uniformization engine
+
+n_ifts - Number of IFT's.
+x - IFT positions (same notation as x0 in the InitialConditions struct).
+head - index of the IFT closest to the retrograde end (MOVE_EXCLUSION only).
+speed - the IFTs' speeds, from the initial conditions.
+top_speed - the largest speed (1 without speeds).
+capacity - the number of ticks the batch arrays hold (grown as needed).
+tick - the times of the batch's ticks, in increasing order.
+slot - where each tick falls in [0,Lambda).
+scratch, bucket - workspace for sorting the times.
+next - the next tick of the batch.
+n_ticks - the number of ticks in the batch.
+end - the end of the batch's interval.
+ticking - zero until the first batch of the run is drawn.
+*/
+
+
+static void unif_sort( const double u[], double out[], unsigned bucket[],
+	const unsigned n )
+/* Puts the n numbers of [0,1) in u into out in increasing order: into one
+   of n buckets each by counting, then by insertion, which only moves them
+   within their bucket. */
+{
+	unsigned b, k, c, sum = 0;
+	double v;
+
+	for( b = 0; b < n; b++ ) bucket[b] = 0;
+	for( k = 0; k < n; k++ ) ++bucket[ (unsigned) ( u[k] * n ) ];
+	for( b = 0; b < n; b++ ){
+		c = bucket[b];
+		bucket[b] = sum;
+		sum += c;
+	}
+	for( k = 0; k < n; k++ )
+		out[ bucket[ (unsigned) ( u[k] * n ) ]++ ] = u[k];
+
+	for( k = 1; k < n; k++ ){
+		v = out[k];
+		for( c = k; c > 0 && out[c-1] > v; c-- ) out[c] = out[c-1];
+		out[c] = v;
+	}
+}
+
+static void unif_grow( UniformizationState * s, const unsigned n ){
+
+	s->capacity = n;
+	s->tick = (double *) realloc( s->tick, n * sizeof(double) );
+	s->slot = (double *) realloc( s->slot, n * sizeof(double) );
+	s->scratch = (double *) realloc( s->scratch, n * sizeof(double) );
+	s->bucket = (unsigned *) realloc( s->bucket, n * sizeof(unsigned) );
+}
+
+static void unif_batch( UniformizationState * s, Rng * rng,
+	const double begin, const double end, const double lambda )
+/* Draws the ticks of [begin,end) at rate lambda. */
+{
+	const double span = end - begin;
+	const unsigned n = rand_poisson( rng, lambda * span );
+	unsigned k;
+
+	if( n > s->capacity ) unif_grow( s, n );
+
+	for( k = 0; k < n; k++ ) s->scratch[k] = rng_uniform( rng );
+	unif_sort( s->scratch, s->tick, s->bucket, n );
+	for( k = 0; k < n; k++ ) s->tick[k] = begin + span * s->tick[k];
+
+	for( k = 0; k < n; k++ ) s->slot[k] = rng_uniform( rng );
+	for( k = 0; k < n; k++ ) s->slot[k] *= lambda;
+
+	s->next = 0;
+	s->n_ticks = n;
+	s->end = end;
+}
+
+void * uniformization_create( const InitialConditions * const ic ){
+
+	UniformizationState * s =
+		(UniformizationState *) malloc( sizeof(UniformizationState) );
+
+	s->n_ifts = ic->n_ifts;
+	s->x = (int *) malloc( ( ic->n_ifts + (ic->n_ifts == 0) ) * sizeof(int) );
+	s->tick = s->slot = s->scratch = NULL;
+	s->bucket = NULL;
+	unif_grow( s, 4 * UNIF_BATCH );
+
+	return s;
+}
+
+void uniformization_reset( void * state, const InitialConditions * const ic ){
+
+	UniformizationState * s = state;
+	unsigned i;
+
+	s->head = 0;
+	s->top_speed = 1;
+	for( i = 0; i < s->n_ifts; i++ ){
+		s->x[i] = ic->x0[i];
+		if( s->x[i] < s->x[s->head] ) s->head = i;
+		if( ic->speed && ( i == 0 || ic->speed[i] > s->top_speed ) )
+			s->top_speed = ic->speed[i];
+	}
+	s->speed = ic->speed;
+	s->ticking = 0;
+}
+
+void uniformization_destroy( void * state ){
+
+	UniformizationState * s = state;
+
+	free( s->x );
+	free( s->tick );
+	free( s->slot );
+	free( s->scratch );
+	free( s->bucket );
+	free( s );
+}
+
+int uniformization_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+/*int uniformization_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+Represents a single step of the simulation, with the same dynamics as
+ift_step but events taken from the thinned ticks.  Self-loops are skipped.
+
+Return value:
+The change in length (+1, 0, or -1)
+*/
+{
+	UniformizationState * s = state;
+	const unsigned n = s->n_ifts;
+	const double top = p->lambda_p > p->lambda_m ? p->lambda_p : p->lambda_m;
+	const double width = top * s->top_speed;
+	const double moves = n * width;
+	const double lambda = moves + p->mu;
+	double u, begin;
+	unsigned j;
+#if IFT_MOVE == MOVE_FREE
+	unsigned i;
+#endif
+
+	if( lambda <= 0 ){ /* Nothing ever happens */
+		*t = time_limit;
+		return 0;
+	}
+
+	if( !s->ticking ){
+		s->next = s->n_ticks = 0;
+		s->end = *t;
+		s->ticking = 1;
+	}
+
+	for( ;; ){
+
+		if( s->next == s->n_ticks ){ /* Next batch */
+
+			if( ( begin = s->end ) >= time_limit ){
+				*t = time_limit;
+				return 0;
+			}
+			unif_batch( s, rng, begin, begin + UNIF_BATCH / lambda < time_limit
+				? begin + UNIF_BATCH / lambda : time_limit, lambda );
+			continue;
+		}
+
+		u = s->slot[ s->next ];
+		*t = s->tick[ s->next++ ];
+
+		if( u >= moves ){ /* Disassembly */
+
+			if( !can_disassemble( n, *length ) ) continue;
+
+			/* Decrease Length. */
+			--(*length);
+
+#if IFT_MOVE == MOVE_EXCLUSION
+			/* Move the IFTs on the disassembled segment */
+			if( n > 0 ){
+				push_down( s->x, n, *length, (s->head+n-1) % n );
+				push_up( s->x, n, *length, s->head );
+			}
+#else
+			/* Move IFTs on Disassembled segment down. */
+			for( i = 0; i < n; i++ )
+				s->x[i] += -(s->x[i] == (*length)+1) + (s->x[i] == -(*length)-1);
+#endif
+			return -1;
+		}
+
+		/* Move of IFT j, if the tick falls within its rate */
+		j = (unsigned) ( u / width );
+		if( j >= n ) j = n - 1;
+		if( u - j * width >= ( s->speed ? s->speed[j] : 1 )
+			* ( s->x[j] >= 0 ? p->lambda_p : p->lambda_m ) ) continue;
+
+		if( s->x[j] > *length - 1 ){ /* Then assembly occurs */
+
+			/* Increase length. */
+			++(*length);
+			/* Change direction on IFT */
+			s->x[j] = -(*length);
+			s->head = j;
+			return +1;
+		}
+
+#if IFT_MOVE == MOVE_EXCLUSION
+		/* A blocked IFT stays */
+		if( s->x[ (j+1) % n ] == s->x[j] + 1 ) continue;
+#endif
+		++(s->x[j]);
+		return 0;
+	}
+}
+
+const Engine uniformization_engine = { "uniformization",
+	uniformization_create, uniformization_reset, uniformization_step,
+	uniformization_destroy, 1 };
+
+#endif
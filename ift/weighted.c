@@ -0,0 +1,212 @@
+/* Author: Yuriy Sverchkov
+   Filename: weighted.c
+   Purpose: Sum-tree engine for the IFT simulation with IFTs of different
+   speeds (see InitialConditions).
+   The grouped engine relies on every anterograde IFT having the same rate,
+   and ift_step finds the event by scanning all the rates.  This engine keeps
+   the rate of every IFT move and of the disassembly in a sum tree, so the
+   event is found in O(log n_ifts) and only the rates an event changes are
+   updated: the moving IFT's, those of IFTs pushed by a disassembly, and
+   under crowding the one behind the moving IFT.
+   Included by ift.c for either movement rule (IFT_MOVE).
+*/
+
+#ifndef WEIGHTED_C_INCLUDED
+#define WEIGHTED_C_INCLUDED
+
+#include "sumtree.c"
+#if IFT_MOVE == MOVE_EXCLUSION
+#include "exclusion.c"
+#endif
+
+typedef struct{
+	unsigned n_ifts;
+	int * x;
+	unsigned head;
+	const double * speed;
+	SumTree rates;
+	short filled;
+} WeightedState;
+/*WeightedState: State of the sum-tree engine
+
+Cells 0 to n_ifts-1 of the tree are the moves of the IFTs, cell n_ifts is
+the disassembly.
+
+n_ifts - Number of IFT's.
+x - IFT positions (same notation as x0 in the InitialConditions struct).
+head - index of the IFT closest to the retrograde end (MOVE_EXCLUSION only).
+speed - the IFTs' speeds, from the initial conditions.
+rates - the rate of each event.
+filled - zero if the rates have to be computed at the next step (they
+	depend on the parameters, which only the step gets).
+*/
+
+
+void weighted_update( WeightedState * s, const Parameters * const p,
+	const unsigned i, const int length )
+/* Sets the rate of event i for the given length. */
+{
+	int x;
+
+	if( i == s->n_ifts ){
+		stSet( &(s->rates), i, p->mu * can_disassemble( s->n_ifts, length ) );
+		return;
+	}
+
+	x = s->x[i];
+#if IFT_MOVE == MOVE_EXCLUSION
+	/* Blocked by the IFT ahead; an IFT at the tip can always move */
+	if( x < length && s->x[ (i+1) % s->n_ifts ] == x + 1 ){
+		stSet( &(s->rates), i, 0 );
+		return;
+	}
+#endif
+	stSet( &(s->rates), i, ( s->speed ? s->speed[i] : 1 )
+		* ( x >= 0 ? p->lambda_p : p->lambda_m ) );
+}
+
+void * weighted_create( const InitialConditions * const ic ){
+
+	WeightedState * s = (WeightedState *) malloc( sizeof(WeightedState) );
+
+	s->n_ifts = ic->n_ifts;
+	s->x = (int *) malloc( ( ic->n_ifts + (ic->n_ifts == 0) ) * sizeof(int) );
+	s->rates = stCreate( ic->n_ifts + 1 );
+
+	return s;
+}
+
+void weighted_reset( void * state, const InitialConditions * const ic ){
+
+	WeightedState * s = state;
+	unsigned i;
+
+	s->head = 0;
+	for( i = 0; i < s->n_ifts; i++ ){
+		s->x[i] = ic->x0[i];
+		if( s->x[i] < s->x[s->head] ) s->head = i;
+	}
+	s->speed = ic->speed;
+	s->filled = 0;
+}
+
+void weighted_destroy( void * state ){
+
+	WeightedState * s = state;
+
+	stDestroy( s->rates );
+	free( s->x );
+	free( s );
+}
+
+int weighted_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+/*int weighted_step( void * state, const Parameters * const p,
+	Rng * rng, const double time_limit, double * t, int * length )
+Represents a single step of the simulation, with the same dynamics as
+ift_step but O(log n_ifts) event selection.  Under crowding, blocked moves
+are never picked (see unblocked.c).
+
+Return value:
+The change in length (+1, 0, or -1)
+*/
+{
+	WeightedState * s = state;
+	const unsigned n = s->n_ifts;
+	unsigned i, j;
+#if IFT_MOVE == MOVE_EXCLUSION
+	unsigned k;
+#endif
+	double tau = 0;
+	double rate_sum;
+	short length_change = 0;
+
+	if( !s->filled ){
+		for( i = 0; i <= n; i++ )
+			weighted_update( s, p, i, *length );
+		s->filled = 1;
+	}
+
+	rate_sum = stTotal( &(s->rates) );
+
+	if( rate_sum <= 0 ){ /* Every IFT is blocked and the length is 0 */
+		tau = time_limit - *t;
+	}else{
+		/* Get time until next event */
+		tau = ift_wait( rng ) / rate_sum;
+
+		/* Check if next event is within the time limit */
+		if( tau + *t > time_limit )
+			tau = time_limit - *t;
+
+		else if( ( j = stFind( &(s->rates), rate_sum * rng_uniform( rng ) ) )
+			== n ){ /* Disassembly */
+
+			/* Decrease Length. */
+			*length += ( length_change = -1 );
+
+#if IFT_MOVE == MOVE_EXCLUSION
+			/* Move the IFTs on the disassembled segment, then update the
+			   moved blocks and the IFT behind each of them. */
+			if( n > 0 ){
+				j = (s->head+n-1) % n;
+				for( k = push_down( s->x, n, *length, j ) + 1; k > 0; k-- ){
+					weighted_update( s, p, j, *length );
+					j = (j+n-1) % n;
+				}
+
+				j = (s->head+n-1) % n;
+				for( k = push_up( s->x, n, *length, s->head ) + 1; k > 0; k-- ){
+					weighted_update( s, p, j, *length );
+					j = (j+1) % n;
+				}
+			}
+#else
+			/* Move IFTs on Disassembled segment down; those pushed onto
+			   the base turn anterograde. */
+			for( i = 0; i < n; i++ )
+				if( s->x[i] == (*length)+1 )
+					--(s->x[i]);
+				else if( s->x[i] == -(*length)-1 && ++(s->x[i]) == 0 )
+					weighted_update( s, p, i, *length );
+#endif
+
+			if( !can_disassemble( n, *length ) )
+				weighted_update( s, p, n, *length );
+
+		}else{ /* Move IFT */
+
+			if( s->x[j] > *length - 1 ){ /* Then assembly occurs */
+
+				/* Increase length. */
+				*length += ( length_change = +1 );
+				/* Change direction on IFT */
+				s->x[j] = -(*length);
+				s->head = j;
+				weighted_update( s, p, j, *length );
+
+				if( !can_disassemble( n, *length - 1 ) )
+					weighted_update( s, p, n, *length );
+
+			}else if( ++(s->x[j]) == 0 ) /* Reached the base */
+				weighted_update( s, p, j, *length );
+
+#if IFT_MOVE == MOVE_EXCLUSION
+			/* j may now be blocked, and the IFT behind j may have been
+			   waiting for it */
+			weighted_update( s, p, j, *length );
+			weighted_update( s, p, (j+n-1) % n, *length );
+#endif
+		}
+	}
+
+	/* Update time */
+	*t += tau;
+
+	return length_change;
+}
+
+const Engine weighted_engine = { "weighted",
+	weighted_create, weighted_reset, weighted_step, weighted_destroy, 1 };
+
+#endif
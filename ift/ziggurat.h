@@ -0,0 +1,231 @@
+/* Generated by mkziggurat.c, do not edit. */
+
+#define ZIG_LAYERS 256
+#define ZIG_TAIL 7.6971174701310501
+
+/* k[i]: the word is inside layer i's rectangle if below this */
+static const unsigned long zig_k[ZIG_LAYERS] = {
+	14848161UL, 15129198UL, 15658929UL, 15911694UL, 16061744UL, 16161893UL,
+	16233847UL, 16288240UL, 16330913UL, 16365357UL, 16393787UL, 16417682UL,
+	16438068UL, 16455680UL, 16471057UL, 16484608UL, 16496645UL, 16507411UL,
+	16517102UL, 16525871UL, 16533847UL, 16541132UL, 16547814UL, 16553965UL,
+	16559645UL, 16564906UL, 16569794UL, 16574345UL, 16578593UL, 16582567UL,
+	16586292UL, 16589790UL, 16593081UL, 16596181UL, 16599107UL, 16601871UL,
+	16604487UL, 16606964UL, 16609314UL, 16611545UL, 16613665UL, 16615681UL,
+	16617601UL, 16619430UL, 16621174UL, 16622837UL, 16624426UL, 16625943UL,
+	16627394UL, 16628780UL, 16630107UL, 16631377UL, 16632593UL, 16633757UL,
+	16634873UL, 16635942UL, 16636967UL, 16637949UL, 16638891UL, 16639795UL,
+	16640661UL, 16641491UL, 16642288UL, 16643052UL, 16643784UL, 16644486UL,
+	16645158UL, 16645803UL, 16646421UL, 16647012UL, 16647578UL, 16648119UL,
+	16648637UL, 16649132UL, 16649604UL, 16650055UL, 16650485UL, 16650894UL,
+	16651284UL, 16651654UL, 16652005UL, 16652338UL, 16652654UL, 16652951UL,
+	16653232UL, 16653495UL, 16653742UL, 16653974UL, 16654189UL, 16654389UL,
+	16654574UL, 16654744UL, 16654899UL, 16655040UL, 16655166UL, 16655279UL,
+	16655377UL, 16655462UL, 16655534UL, 16655592UL, 16655637UL, 16655669UL,
+	16655688UL, 16655694UL, 16655687UL, 16655668UL, 16655636UL, 16655592UL,
+	16655535UL, 16655465UL, 16655384UL, 16655290UL, 16655183UL, 16655065UL,
+	16654934UL, 16654791UL, 16654635UL, 16654467UL, 16654287UL, 16654095UL,
+	16653890UL, 16653672UL, 16653442UL, 16653199UL, 16652944UL, 16652676UL,
+	16652395UL, 16652101UL, 16651793UL, 16651473UL, 16651139UL, 16650792UL,
+	16650431UL, 16650056UL, 16649667UL, 16649264UL, 16648847UL, 16648415UL,
+	16647969UL, 16647507UL, 16647030UL, 16646538UL, 16646029UL, 16645505UL,
+	16644964UL, 16644407UL, 16643833UL, 16643242UL, 16642632UL, 16642005UL,
+	16641360UL, 16640695UL, 16640012UL, 16639309UL, 16638585UL, 16637841UL,
+	16637076UL, 16636290UL, 16635481UL, 16634649UL, 16633795UL, 16632916UL,
+	16632012UL, 16631083UL, 16630128UL, 16629147UL, 16628137UL, 16627100UL,
+	16626033UL, 16624936UL, 16623807UL, 16622647UL, 16621453UL, 16620225UL,
+	16618961UL, 16617660UL, 16616322UL, 16614944UL, 16613526UL, 16612065UL,
+	16610560UL, 16609009UL, 16607412UL, 16605765UL, 16604066UL, 16602315UL,
+	16600508UL, 16598643UL, 16596718UL, 16594730UL, 16592677UL, 16590554UL,
+	16588360UL, 16586091UL, 16583743UL, 16581312UL, 16578795UL, 16576186UL,
+	16573482UL, 16570677UL, 16567767UL, 16564744UL, 16561603UL, 16558338UL,
+	16554941UL, 16551404UL, 16547720UL, 16543878UL, 16539869UL, 16535683UL,
+	16531308UL, 16526731UL, 16521937UL, 16516913UL, 16511642UL, 16506104UL,
+	16500280UL, 16494148UL, 16487683UL, 16480857UL, 16473641UL, 16465999UL,
+	16457894UL, 16449284UL, 16440118UL, 16430344UL, 16419898UL, 16408709UL,
+	16396697UL, 16383767UL, 16369810UL, 16354700UL, 16338288UL, 16320400UL,
+	16300827UL, 16279320UL, 16255579UL, 16229238UL, 16199845UL, 16166839UL,
+	16129512UL, 16086957UL, 16037997UL, 15981072UL, 15914072UL, 15834075UL,
+	15736910UL, 15616422UL, 15463134UL, 15261681UL, 14985448UL, 14584127UL,
+	13950393UL, 12810156UL, 10218206UL, 0UL
+};
+
+/* w[i]: layer width / 2^24 */
+static const double zig_w[ZIG_LAYERS] = {
+	5.1838859737700729e-07, 4.587839526016146e-07, 4.13717843853069e-07,
+	3.861414488454203e-07, 3.6622075234487474e-07, 3.5060312246056773e-07,
+	3.3774436518275917e-07, 3.2680574819600933e-07, 3.1728091870274511e-07,
+	3.0884070881018022e-07, 3.012590700376809e-07, 2.943740538299827e-07,
+	2.880656564846699e-07, 2.8224247673760275e-07, 2.7683328899264817e-07,
+	2.7178150783224982e-07, 2.6704142967035875e-07, 2.6257560810289191e-07,
+	2.5835297586424754e-07, 2.5434747220738896e-07, 2.5053702078671336e-07,
+	2.4690275583648962e-07, 2.4342842760135492e-07, 2.4009993938493325e-07,
+	2.3690498272620346e-07, 2.3383274675223144e-07, 2.3087368431088356e-07,
+	2.2801932206883027e-07, 2.252621050126352e-07, 2.2259526813267427e-07,
+	2.2001272977813568e-07, 2.1750900243287381e-07, 2.1507911760383279e-07,
+	2.1271856222440797e-07, 2.1042322451647159e-07, 2.0818934767091606e-07,
+	2.0601349002914168e-07, 2.0389249069995379e-07, 2.0182343974472862e-07,
+	1.9980365222097071e-07, 1.9783064549986983e-07, 1.9590211937421946e-07,
+	1.9401593855443274e-07, 1.9217011721648336e-07, 1.9036280531956174e-07,
+	1.8859227645551973e-07, 1.8685691702869153e-07, 1.8515521659492374e-07,
+	1.8348575921381031e-07, 1.8184721568914954e-07, 1.8023833659027053e-07,
+	1.7865794596172131e-07, 1.7710493564135344e-07, 1.7557826011747368e-07,
+	1.7407693186478236e-07, 1.7260001710654124e-07, 1.7114663195702624e-07,
+	1.697159389039984e-07, 1.6830714359581654e-07, 1.6691949190203746e-07,
+	1.6555226722000552e-07, 1.6420478800310732e-07, 1.6287640548912857e-07,
+	1.6156650160955932e-07, 1.6027448706279986e-07, 1.5899979953606496e-07,
+	1.5774190206240438e-07, 1.5650028150068421e-07, 1.5527444712763013e-07,
+	1.5406392933214518e-07, 1.5286827840309739e-07, 1.5168706340264467e-07,
+	1.5051987111793889e-07, 1.4936630508474042e-07, 1.4822598467708851e-07,
+	1.4709854425772187e-07, 1.4598363238443401e-07, 1.4488091106798734e-07,
+	1.4379005507760437e-07, 1.4271075129040793e-07, 1.4164269808150144e-07,
+	1.4058560475166631e-07, 1.3953919098991329e-07, 1.3850318636835757e-07,
+	1.3747732986709917e-07, 1.3646136942698143e-07, 1.3545506152827436e-07,
+	1.3445817079348644e-07, 1.3347046961265226e-07, 1.3249173778957314e-07,
+	1.3152176220760692e-07, 1.3056033651371087e-07, 1.2960726081954055e-07,
+	1.2866234141849758e-07, 1.2772539051770188e-07, 1.2679622598393932e-07,
+	1.2587467110270479e-07, 1.2496055434952433e-07, 1.2405370917279836e-07,
+	1.2315397378746093e-07, 1.2226119097880003e-07, 1.2137520791582848e-07,
+	1.2049587597363715e-07, 1.1962305056420045e-07, 1.187565909751398e-07,
+	1.1789636021598307e-07, 1.1704222487148895e-07, 1.1619405496163243e-07,
+	1.1535172380787405e-07, 1.1451510790535938e-07, 1.1368408680071719e-07,
+	1.1285854297514569e-07, 1.1203836173249513e-07, 1.1122343109207282e-07,
+	1.1041364168591317e-07, 1.096088866602703e-07, 1.0880906158110579e-07,
+	1.0801406434335614e-07, 1.0722379508377817e-07, 1.064381560971808e-07,
+	1.0565705175586335e-07, 1.0488038843208957e-07, 1.0410807442343639e-07,
+	1.0334001988086491e-07, 1.0257613673936897e-07, 1.0181633865106412e-07,
+	1.0106054092058727e-07, 1.0030866044268295e-07, 9.9560615641858916e-08,
+	9.8816326413998981e-08, 9.8075714069826437e-08, 9.7338701280116135e-08,
+	9.6605212022557942e-08, 9.5875171530178305e-08, 9.5148506241230783e-08,
+	9.4425143750469831e-08, 9.3705012761725382e-08, 9.2988043041699031e-08,
+	9.2274165374905279e-08, 9.1563311519683923e-08, 9.0855414165211892e-08,
+	9.0150406889445211e-08, 8.9448224117923397e-08, 8.8748801083370411e-08,
+	8.8052073786027861e-08, 8.7357978954657238e-08, 8.6666454008149326e-08,
+	8.5977437017679576e-08, 8.5290866669349267e-08, 8.4606682227252517e-08,
+	8.392482349690968e-08, 8.3245230789007871e-08, 8.2567844883389208e-08,
+	8.1892606993227238e-08, 8.12194587293315e-08, 8.054834206451945e-08,
+	7.9879199297994281e-08, 7.9211973019666083e-08, 7.8546606074352164e-08,
+	7.7883041525791149e-08, 7.7221222620403431e-08, 7.6561092750728487e-08,
+	7.5902595418467193e-08, 7.5245674197054426e-08, 7.459027269368445e-08,
+	7.3936334510707837e-08, 7.3283803206315186e-08, 7.2632622254418341e-08,
+	7.198273500363554e-08, 7.1334084635281324e-08, 7.0686614120256608e-08,
+	7.0040266174727938e-08, 6.9394983214477992e-08, 6.8750707307801689e-08,
+	6.8107380126813979e-08, 6.7464942897026027e-08, 6.6823336345036228e-08,
+	6.6182500644171472e-08, 6.5542375357901466e-08, 6.4902899380835277e-08,
+	6.4264010877094579e-08, 6.362564721584085e-08, 6.2987744903716107e-08,
+	6.2350239513935857e-08, 6.1713065611751152e-08, 6.1076156675971157e-08,
+	6.0439445016210638e-08, 5.9802861685495937e-08, 5.9166336387829093e-08,
+	5.8529797380271862e-08, 5.7893171369069572e-08, 5.7256383399287407e-08,
+	5.6619356737379344e-08, 5.5982012746051243e-08, 5.5344270750713525e-08,
+	5.4706047896745012e-08, 5.406725899670617e-08, 5.3427816366546296e-08,
+	5.2787629649743072e-08, 5.2146605628193462e-08, 5.1504648018538756e-08,
+	5.08616572524527e-08, 5.0217530239245927e-08, 4.9572160108939713e-08,
+	4.8925435933733214e-08, 4.8277242425525795e-08, 4.7627459606854854e-08,
+	4.6975962452261706e-08, 4.6322620496697508e-08, 4.5667297407116069e-08,
+	4.5009850512860631e-08, 4.4350130289822784e-08, 4.3687979792616166e-08,
+	4.3023234028145511e-08, 4.2355719262936476e-08, 4.1685252255393443e-08,
+	4.1011639402731586e-08, 4.0334675790638535e-08, 3.9654144131700314e-08,
+	3.8969813576200933e-08, 3.8281438375981267e-08, 3.7588756378500499e-08,
+	3.6891487323931838e-08, 3.6189330912845746e-08, 3.548196460553962e-08,
+	3.4769041106030918e-08, 3.4050185473714955e-08, 3.3324991793127667e-08,
+	3.2593019316393126e-08, 3.1853787972757502e-08, 3.1106773113734964e-08,
+	3.0351399328925799e-08, 2.9587033123890142e-08, 2.8812974193897852e-08,
+	2.8028444950709172e-08, 2.7232577856266983e-08, 2.6424399976345309e-08,
+	2.5602813972556488e-08, 2.4766574478169894e-08, 2.3914258414284269e-08,
+	2.3044227238959443e-08, 2.2154578288191767e-08, 2.1243081108235104e-08,
+	2.0307092730095067e-08, 1.9343442739063168e-08, 1.8348273913557328e-08,
+	1.7316815584374323e-08, 1.6243051617053018e-08, 1.5119216643923172e-08,
+	1.3934998694637755e-08, 1.2676209845003257e-08, 1.1322420216942411e-08,
+	9.8423732855417014e-09, 8.1840146148195681e-09, 6.248862002240724e-09,
+	3.8058855423305181e-09
+};
+
+/* f[i]: density at the right edge of layer i (f[ZIG_LAYERS] = 1) */
+static const double zig_f[ZIG_LAYERS+1] = {
+	0.00016706669230795803, 0.0004541343538414966, 0.00096726928232717605,
+	0.0015362997803015767, 0.0021459677437189128, 0.0027887987935740857,
+	0.0034602647778369166, 0.0041572951208338118, 0.0048776559835424131,
+	0.005619642207205509, 0.006381905937319206, 0.0071633531836350168,
+	0.0079630774380170782, 0.0087803149858090151, 0.009614413642502255,
+	0.010464810181030028, 0.011331013597834651, 0.012212592426255444,
+	0.01310916493125506, 0.014020391403182004, 0.014945968011691214,
+	0.015885621839973229, 0.016839106826040014, 0.017806200410911435,
+	0.018786700744696107, 0.019780424338009826, 0.020787204072578207,
+	0.021806887504283678, 0.022839335406385341, 0.023884420511558282,
+	0.024942026419731898, 0.026012046645134335, 0.027094383780955921,
+	0.028188948763978757, 0.029295660224637525, 0.030414443910466743,
+	0.031545232172893747, 0.032687963508959687, 0.03384258215087449,
+	0.03500903769739757, 0.036187284781931589, 0.037377282772959528,
+	0.038578995503075024, 0.039792391023374299, 0.041017441380415007,
+	0.042254122413316428, 0.043502413568888391, 0.04476229773294349,
+	0.046033761076175385, 0.047316792913181777, 0.048611385573379719,
+	0.049917534282706601, 0.051235237055126504, 0.052564494593071921,
+	0.053905310196046316, 0.055257689676697273, 0.05662164128374312,
+	0.057997175631200916, 0.059384305633420544, 0.060783046445479931,
+	0.062193415408541314, 0.063615431999807667, 0.065049117786754082,
+	0.066494496385340121, 0.067951593421936976, 0.069420436498729129,
+	0.070901055162372217, 0.07239348087570914, 0.073897746992365135,
+	0.075413888734058812, 0.076941943170480934, 0.078481949201606852,
+	0.080033947542320363, 0.081597980709237891, 0.083174093009632841,
+	0.08476233053236859, 0.086362741140757385, 0.087975374467270703,
+	0.089600281910033358, 0.091237516631040683, 0.092887133556044069,
+	0.094549189376056372, 0.096223742550433339, 0.097910853311492768,
+	0.099610583670637715, 0.10132299742595421, 0.1030481601712583,
+	0.10478613930657076, 0.10653700405000224, 0.10830082545103438,
+	0.110077676405186, 0.11186763167005694, 0.11367076788274494,
+	0.11548716357863417, 0.11731689921155621, 0.11916005717532833,
+	0.12101672182667549, 0.12288697950954582, 0.12477091858083166,
+	0.12666862943751134, 0.12858020454522887, 0.13050573846833147,
+	0.13244532790138822, 0.13439907170221438, 0.13636707092642961,
+	0.13834942886358098, 0.14034625107486323, 0.14235764543247301,
+	0.14438372216063561, 0.14642459387834578, 0.14848037564386765,
+	0.15055118500104078, 0.15263714202744377, 0.154738369384469,
+	0.15685499236936615, 0.15898713896931513, 0.16113493991759298,
+	0.16329852875190279, 0.165478041874937, 0.16767361861725122,
+	0.16988540130252872, 0.17211353531532111, 0.17435816917135458,
+	0.17661945459049599, 0.17889754657247942, 0.18119260347549743,
+	0.1835047870977686, 0.18583426276219828, 0.18818119940425548,
+	0.19054576966319658, 0.19292814997677254, 0.19532852067956447,
+	0.19774706610510009, 0.20018397469191251, 0.20263943909371027,
+	0.20511365629383899, 0.20760682772422334, 0.21011915938898959,
+	0.21265086199297964, 0.21520215107538007, 0.21777324714870192,
+	0.22036437584336088, 0.22297576805812155, 0.22560766011668545,
+	0.22826029393071814, 0.23093391716962888, 0.23362878343743479,
+	0.23634515245706109, 0.23908329026245065, 0.24184346939887874,
+	0.24462596913189366, 0.24743107566532918, 0.25025908236886385,
+	0.25311029001563107, 0.25598500703041699, 0.25888354974901784,
+	0.26180624268936459, 0.26475341883506387, 0.26772541993204652,
+	0.27072259679906174, 0.27374530965280475, 0.27679392844851919,
+	0.27986883323697476, 0.28297041453878263, 0.28609907373707877,
+	0.28925522348967969, 0.29243928816189457, 0.29565170428126325,
+	0.2988929210155839, 0.30216340067569569, 0.30546361924459248,
+	0.30879406693456246, 0.31215524877418188, 0.31554768522713128,
+	0.31897191284495957, 0.3224284849560915, 0.32591797239355857,
+	0.32944096426413882, 0.33299806876181143, 0.3365899140286801,
+	0.34021714906678258, 0.34388044470450502, 0.34758049462163959,
+	0.35131801643748606, 0.35509375286679018, 0.3589084729487525,
+	0.36276297335482061, 0.36665807978151704, 0.37059464843514894,
+	0.37457356761590516, 0.37859575940958384, 0.38266218149601289,
+	0.38677382908414082, 0.39093173698480027, 0.39513698183329338,
+	0.39939068447523435, 0.40369401253053361, 0.40804818315203578,
+	0.41245446599716462, 0.41691418643300643, 0.42142872899762018,
+	0.42599954114303801, 0.43062813728846255, 0.4353161032156404,
+	0.44006510084235773, 0.44487687341455245, 0.44975325116275899,
+	0.45469615747461956, 0.45970761564214185, 0.46478975625043045,
+	0.46994482528396436, 0.47517519303738182, 0.48048336393045876,
+	0.48587198734188958, 0.49134386959403731, 0.49690198724155438,
+	0.50254950184135261, 0.50828977641064788, 0.51412639381475367,
+	0.52006317736823882, 0.52610421398362506, 0.53225388026304876,
+	0.53851687200286746, 0.54489823767244538, 0.55140341654064717,
+	0.55803828226259344, 0.56480919291240639, 0.57172304866483215,
+	0.57878735860285158, 0.58601031847727469, 0.59340090169174031,
+	0.60096896636523933, 0.60872538207962934, 0.61668218091521509,
+	0.62485273870367364, 0.63325199421437406, 0.64189671642727431,
+	0.65080583341457954, 0.66000084107900858, 0.66950631673193395,
+	0.67935057226477491, 0.68956649611708787, 0.70019265508279849,
+	0.71127476080508678, 0.72286765959358334, 0.73503809243143547,
+	0.74786862198520776, 0.76146338884990972, 0.7759568520401301,
+	0.79152763697251138, 0.80842165152302559, 0.82699329664306942,
+	0.84778550062401126, 0.87170433238122902, 0.90046992992577801,
+	0.938143680862219, 1
+};